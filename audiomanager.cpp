@@ -52,7 +52,8 @@ private:
 
 }
 
-AudioManager::Variations::Variations() :
+AudioManager::Variations::Variations(Random& rng) :
+    rng(rng),
     variations(),
     current(variations.end())
 {}
@@ -75,7 +76,7 @@ void AudioManager::Variations::play() noexcept
     }
     else
     {
-        current=variations.begin()+rand()%variations.size();
+        current=variations.begin()+rng.below(variations.size());
         (*current)->play();
     }
 }
@@ -90,8 +91,9 @@ void AudioManager::Variations::stop() noexcept
 }
 
 
-AudioManager::AudioManager() :
-    device(0)
+AudioManager::AudioManager(uint64_t seed) :
+    device(0),
+    rng(seed)
 {
     device=SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, nullptr);
     if (device==0) throw runtime_error("Failed to open auto device: "s+SDL_GetError());
@@ -106,6 +108,16 @@ AudioManager::~AudioManager()
 }
 
 
+void AudioManager::pause()
+{
+    SDL_PauseAudioDevice(device);
+}
+
+void AudioManager::resume()
+{
+    SDL_ResumeAudioDevice(device);
+}
+
 AudioManager::Audio AudioManager::createSimpleAudio(size_t sampleRate, span<float> samples)
 {
     return make_shared<SimpleStream>(
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "common.h"
+#include "random.h"
 
 class AudioManager
 {
@@ -22,20 +23,24 @@ public:
     class Variations : public AudioManager::IStream
     {
     public:
-        Variations();
+        Variations(Random& rng);
         void addVariation(AudioManager::Audio var);
         virtual void play() noexcept;
         virtual void stop() noexcept;
     
     private:
+        Random& rng;
         vector<AudioManager::Audio> variations;
         vector<AudioManager::Audio>::iterator current;
     };
 
 public:
-    AudioManager();
+    AudioManager(uint64_t seed=0);
     ~AudioManager();
 
+    void pause();
+    void resume();
+
     Audio createSimpleAudio(size_t sampleRate, span<float> samples);
     Audio createTone(float frequency, float length, size_t sampleRate);
     Audio loadWav(const filesystem::path& file);
@@ -43,7 +48,7 @@ public:
     template<typename... U>
     inline Audio loadWavWithVariations(U&&... files)
     {
-        auto result=make_shared<Variations>();
+        auto result=make_shared<Variations>(rng);
         auto vars = {loadWav(std::forward<U>(files))... };
         for (auto&& v : vars) result->addVariation(v);
         return result;
@@ -52,4 +57,5 @@ public:
 
 private:
     uint32_t device;
+    Random rng;
 };
\ No newline at end of file
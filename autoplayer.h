@@ -0,0 +1,64 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#pragma once
+
+#include "common.h"
+#include "game.h"
+#include "random.h"
+
+//! @brief computer player that follows the lowest falling ball with the paddle.
+//! Every time that ball starts falling it picks a random spot on the paddle
+//! to aim for, plus an error that grows as the skill drops, so it does
+//! lose balls now and then.
+class AutoPlayer
+{
+public:
+    static constexpr uint64_t RandomStream = 2;
+    static constexpr float MaxError = 4.0f;
+    static constexpr float AimRange = 0.8f;     // fraction of the paddle used for aiming
+    static constexpr float DeadZone = 0.1f;
+
+public:
+    explicit AutoPlayer(uint64_t seed, float skill=0.5f) :
+        rng(seed, RandomStream),
+        skill(clamp(skill, 0.0f, 1.0f)),
+        target(0.0f),
+        falling(false)
+    {}
+
+    Replay::Input think(const Game& game)
+    {
+        const auto& balls=game.getBalls();
+        const auto& player=game.getPlayer();
+        if (ranges::find(balls.stuck, true)!=balls.stuck.end()) return Game::InputLaunch;
+
+        // follow the lowest ball that is coming down, or the lowest one if none is
+        size_t ball=0;
+        for (size_t i=1; i<balls.size(); ++i)
+        {
+            bool fallingI=balls.vy[i]>0.0f, fallingBest=balls.vy[ball]>0.0f;
+            if (fallingI>fallingBest || (fallingI==fallingBest && balls.y[i]>balls.y[ball])) ball=i;
+        }
+
+        bool nowFalling=balls.vy[ball]>0.0f;
+        if (nowFalling && !falling)
+        {
+            float aim=rng.range(-AimRange, AimRange)*player.size.x*0.5f;
+            float error=rng.range(-1.0f, 1.0f)*(1.0f-skill)*MaxError;
+            target=error-aim;
+        }
+        falling=nowFalling;
+
+        float dx=balls.x[ball]+target-player.pos.x;
+        if (dx<-DeadZone) return Game::InputLeft;
+        if (dx>DeadZone) return Game::InputRight;
+        return 0;
+    }
+
+private:
+    Random rng;
+    float skill;
+    float target;   // where the paddle center should be, relative to the ball
+    bool falling;
+};
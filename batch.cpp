@@ -0,0 +1,278 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+
+#include "common.h"
+#include "game.h"
+#include "autoplayer.h"
+#include "jobsystem.h"
+#include "random.h"
+
+#include <chrono>
+#include <fstream>
+#include <format>
+
+using BatchClock = chrono::steady_clock;
+
+namespace
+{
+    struct Options
+    {
+        filesystem::path levels = "levels.pack";
+        size_t games = 1000;
+        uint64_t seed = 1;
+        float dt = 1.0f/60.0f;
+        float maxLevelTime = 300.0f;
+        float skill = 0.5f;
+        size_t balls = 1;
+        size_t threads = JobSystem::defaultWorkerCount();
+        string format;
+        filesystem::path output;
+    };
+
+    struct LevelStats
+    {
+        size_t game;
+        uint64_t seed;
+        size_t level;
+        string file;
+        bool cleared;
+        float time;
+        size_t ballsLost;
+        size_t bricks;
+        size_t powerups;
+        size_t score;
+        float progress;     // fraction of the destructible bricks destroyed
+        double tickTime;    // average microseconds per Game::update
+
+        inline float bricksPerSecond() const noexcept { return time>0.0f ? float(bricks)/time : 0.0f; }
+    };
+
+    //! counts what happens in the current level
+    struct StatsCollector
+    {
+        size_t ballsLost = 0;
+        size_t bricks = 0;
+        size_t powerups = 0;
+        bool completed = false;
+
+        void collect(Game& game)
+        {
+            for (auto&& e : game.getEvents())
+            {
+                switch (e.type)
+                {
+                case Game::Event::LevelCompleted: completed=true; break;
+                case Game::Event::BallLost: ++ballsLost; break;
+                case Game::Event::BrickHit: if (Level::cellHp(e.cell)==0) ++bricks; break;
+                case Game::Event::PowerupChanged: if (e.powerup!=Game::PowerUp::None) ++powerups; break;
+                default: break;
+                }
+            }
+            game.clearEvents();
+        }
+    };
+
+    //! each game gets its own seed, printed with the results so a game can be looked at with breakout --seed
+    uint64_t gameSeed(uint64_t seed, size_t game)
+    {
+        Random rng(seed, game);
+        return (uint64_t(rng.next())<<32) | rng.next();
+    }
+
+    //! play every level once, skipping levels that take longer than maxLevelTime
+    vector<LevelStats> runGame(size_t index, const Options& options)
+    {
+        auto seed=gameSeed(options.seed, index);
+        Game game(options.levels, seed);
+        AutoPlayer player(seed, options.skill);
+        StatsCollector stats;
+        game.setBallsPerLife(options.balls);
+        game.addBalls(options.balls-1);     // the first life has already started
+
+        vector<LevelStats> results;
+        for (size_t i=0; i<game.getLevelCount(); ++i)
+        {
+            stats=StatsCollector();
+            auto level=game.getLevelIndex();
+            auto file=string(game.getLevelName());
+            auto scoreBefore=game.getScore();
+
+            float time=0.0f;
+            size_t ticks=0;
+            BatchClock::duration updateTime{};
+            while (!stats.completed && time<options.maxLevelTime)
+            {
+                game.setInput(player.think(game));
+                game.processInput(options.dt);
+                auto start=BatchClock::now();
+                game.update(options.dt);
+                updateTime+=BatchClock::now()-start;
+                stats.collect(game);
+                time+=options.dt;
+                ++ticks;
+            }
+            results.emplace_back(
+                index, seed, level, file, stats.completed, time,
+                stats.ballsLost, stats.bricks, stats.powerups, game.getScore()-scoreBefore,
+                stats.completed ? 1.0f : 1.0f-float(game.getLevel().getRemainingBricks())/float(max<size_t>(game.getLevel().getDestructibleBricks(), 1)),
+                chrono::duration<double, micro>(updateTime).count()/double(max<size_t>(ticks, 1))
+            );
+
+            if (!stats.completed)
+            {
+                game.setInput(Game::InputNextLevel);
+                game.processInput(0.0f);
+                game.clearEvents();
+            }
+        }
+        return results;
+    }
+
+    void writeCsv(ostream& out, const vector<vector<LevelStats>>& results)
+    {
+        out << "game,seed,level,file,cleared,time,balls_lost,bricks,bricks_per_second,powerups,score,progress,tick_us\n";
+        for (auto&& game : results)
+        {
+            for (auto&& l : game)
+            {
+                out << format("{},{},{},{},{},{:.3f},{},{},{:.3f},{},{},{:.3f},{:.2f}\n",
+                    l.game, l.seed, l.level, l.file, l.cleared ? 1 : 0, l.time, l.ballsLost, l.bricks, l.bricksPerSecond(), l.powerups, l.score, l.progress, l.tickTime);
+            }
+        }
+    }
+
+    void writeJson(ostream& out, const vector<vector<LevelStats>>& results)
+    {
+        out << "[";
+        bool first=true;
+        for (auto&& game : results)
+        {
+            for (auto&& l : game)
+            {
+                // level names come from the level file names, escape them anyway
+                string file;
+                for (char c : l.file)
+                {
+                    if (c=='"' || c=='\\') file+='\\';
+                    file+=c;
+                }
+
+                out << (first ? "\n" : ",\n");
+                out << format("{{\"game\":{},\"seed\":{},\"level\":{},\"file\":\"{}\",\"cleared\":{},\"time\":{:.3f},\"ballsLost\":{},\"bricks\":{},\"bricksPerSecond\":{:.3f},\"powerups\":{},\"score\":{},\"progress\":{:.3f},\"tickMicroseconds\":{:.2f}}}",
+                    l.game, l.seed, l.level, file, l.cleared, l.time, l.ballsLost, l.bricks, l.bricksPerSecond(), l.powerups, l.score, l.progress, l.tickTime);
+                first=false;
+            }
+        }
+        out << "\n]\n";
+    }
+
+    //! per level averages over all games
+    void writeSummary(ostream& out, const vector<vector<LevelStats>>& results)
+    {
+        struct Sum
+        {
+            string file;
+            size_t played = 0;
+            size_t cleared = 0;
+            double clearTime = 0.0;
+            double ballsLost = 0.0;
+            double bricksPerSecond = 0.0;
+            double progress = 0.0;
+            double tickTime = 0.0;
+        };
+        vector<Sum> sums;
+        for (auto&& game : results)
+        {
+            for (auto&& l : game)
+            {
+                if (sums.size()<=l.level) sums.resize(l.level+1);
+                auto& s=sums[l.level];
+                s.file=l.file;
+                ++s.played;
+                s.ballsLost+=l.ballsLost;
+                s.bricksPerSecond+=l.bricksPerSecond();
+                s.progress+=l.progress;
+                s.tickTime+=l.tickTime;
+                if (l.cleared)
+                {
+                    ++s.cleared;
+                    s.clearTime+=l.time;
+                }
+            }
+        }
+
+        out << "level          cleared  progress  time to clear  balls lost  bricks/s   tick us\n";
+        for (auto&& s : sums)
+        {
+            if (s.played==0) continue;
+            out << format("{:<14} {:>6.1f}% {:>8.1f}% {:>13.1f}s {:>11.2f} {:>9.2f} {:>9.2f}\n",
+                s.file,
+                100.0*double(s.cleared)/double(s.played),
+                100.0*s.progress/double(s.played),
+                s.cleared ? s.clearTime/double(s.cleared) : 0.0,
+                s.ballsLost/double(s.played),
+                s.bricksPerSecond/double(s.played),
+                s.tickTime/double(s.played));
+        }
+    }
+}
+
+//! runs many games with the auto player at once and collects per-level statistics
+//! for balancing powerups and levels. Nothing is rendered.
+int main(int argc, char* argv[])
+try {
+    Options options;
+    for (int i=1; i<argc; ++i)
+    {
+        auto arg=string_view(argv[i]);
+        if (arg=="--games" && i+1<argc) options.games=stoul(argv[++i]);
+        else if (arg=="--seed" && i+1<argc) options.seed=stoull(argv[++i]);
+        else if (arg=="--levels" && i+1<argc) options.levels=argv[++i];
+        else if (arg=="--dt" && i+1<argc) options.dt=stof(argv[++i]);
+        else if (arg=="--max-level-time" && i+1<argc) options.maxLevelTime=stof(argv[++i]);
+        else if (arg=="--skill" && i+1<argc) options.skill=stof(argv[++i]);
+        else if (arg=="--balls" && i+1<argc) options.balls=max<size_t>(stoul(argv[++i]), 1);
+        else if (arg=="--threads" && i+1<argc) options.threads=stoul(argv[++i]);
+        else if (arg=="--format" && i+1<argc) options.format=argv[++i];
+        else if (arg=="--output" && i+1<argc) options.output=argv[++i];
+        else throw runtime_error("unknown argument '"s+argv[i]+"'. Usage: breakout-batch [--games N] [--seed N] [--levels file] [--dt seconds] "
+            "[--max-level-time seconds] [--skill 0..1] [--balls N] [--threads N] [--format csv|json] [--output file]");
+    }
+    if (options.dt<=0.0f) throw runtime_error("--dt must be positive");
+    if (options.format.empty()) options.format=options.output.extension()==".json" ? "json" : "csv";
+    if (options.format!="csv" && options.format!="json") throw runtime_error("unknown format '"+options.format+"'");
+
+    JobSystem jobs(options.threads);
+    vector<vector<LevelStats>> results(options.games);
+
+    auto start=BatchClock::now();
+    jobs.parallelFor(options.games, 1, [&results, &options](size_t begin, size_t end) {
+        for (size_t i=begin; i<end; ++i) results[i]=runGame(i, options);
+    });
+    auto elapsed=chrono::duration<double>(BatchClock::now()-start).count();
+
+    ofstream file;
+    if (!options.output.empty())
+    {
+        file.open(options.output);
+        if (!file) throw runtime_error("Failed to open output file '"+options.output.string()+"'");
+    }
+    auto& out=options.output.empty() ? cout : file;
+    if (options.format=="json") writeJson(out, results);
+    else writeCsv(out, results);
+
+    cerr << format("{} games on {} threads in {:.2f}s ({:.1f} games/s)\n", options.games, jobs.getWorkerCount()+1, elapsed, double(options.games)/elapsed);
+    writeSummary(cerr, results);
+    return 0;
+}
+catch (runtime_error& e)
+{
+    cerr << "runtime error: " << e.what() << std::endl;
+    return 2;
+}
+catch (...)
+{
+    cerr << "unknown error" << std::endl;
+    return -1;
+}
@@ -71,7 +71,7 @@ DeviceImage::DeviceImage(
             .imageType = vk::ImageType::e2D,
             .format = description.format,
             .extent = { description.extent.width, description.extent.height, 1 },
-            .mipLevels = 1,
+            .mipLevels = description.mipLevels,
             .arrayLayers = 1,
             .samples = samples,
             .tiling = vk::ImageTiling::eOptimal,
@@ -87,7 +87,7 @@ DeviceImage::DeviceImage(
         .image=image,
         .viewType=vk::ImageViewType::e2D,
         .format=description.format,
-        .subresourceRange={vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1}
+        .subresourceRange={vk::ImageAspectFlagBits::eColor, 0, description.mipLevels, 0, 1}
     });
 }
 
@@ -182,14 +182,33 @@ void DeviceImage::createBarrier(
     vk::ImageLayout srcLayout,
     vk::ImageLayout dstLayout
 )
+{
+    currentStage = srcStageMask;
+    currentAccess = srcAccessMask;
+    currentLayout = srcLayout;
+    auto barrier = getTransition(dstStageMask, dstAccessMask, dstLayout, false);
+    vk::DependencyInfo dependencyInfo = {
+        .dependencyFlags = {},
+        .imageMemoryBarrierCount = 1,
+        .pImageMemoryBarriers = &barrier
+    };
+    commandBuffer.pipelineBarrier2(dependencyInfo);
+}
+
+vk::ImageMemoryBarrier2 DeviceImage::getTransition(
+    vk::PipelineStageFlags2 dstStageMask,
+    vk::AccessFlags2 dstAccessMask,
+    vk::ImageLayout dstLayout,
+    bool discard
+)
 {
     auto barrier = vk::ImageMemoryBarrier2
     {
-        .srcStageMask = srcStageMask,
+        .srcStageMask = currentStage,
+        .srcAccessMask = currentAccess,
         .dstStageMask = dstStageMask,
-        .srcAccessMask = srcAccessMask,
         .dstAccessMask = dstAccessMask,
-        .oldLayout = srcLayout,
+        .oldLayout = discard ? vk::ImageLayout::eUndefined : currentLayout,
         .newLayout = dstLayout,
         .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
         .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
@@ -197,21 +216,23 @@ void DeviceImage::createBarrier(
         .subresourceRange = {
             .aspectMask = vk::ImageAspectFlagBits::eColor,
             .baseMipLevel = 0,
-            .levelCount = 1,
+            .levelCount = description.mipLevels,
             .baseArrayLayer = 0,
             .layerCount = 1
         }
     };
-    vk::DependencyInfo dependencyInfo = {
-        .dependencyFlags = {},
-        .imageMemoryBarrierCount = 1,
-        .pImageMemoryBarriers = &barrier
-    };
-    commandBuffer.pipelineBarrier2(dependencyInfo);
     currentStage = dstStageMask;
     currentAccess = dstAccessMask;
     currentLayout = dstLayout;
+    return barrier;
+}
 
+bool DeviceImage::isWritten() const noexcept
+{
+    constexpr auto writes =
+        vk::AccessFlagBits2::eColorAttachmentWrite | vk::AccessFlagBits2::eTransferWrite |
+        vk::AccessFlagBits2::eShaderWrite | vk::AccessFlagBits2::eMemoryWrite;
+    return bool(currentAccess & writes);
 }
 
 
@@ -242,48 +263,46 @@ void BufferManager::resizeStage(vk::DeviceSize minSize) const
 }
 
 void BufferManager::upload(const vk::Buffer& buffer, const vk::BufferCopy& range) const
+{
+    upload([&](const vk::CommandBuffer& commandBuffer) { copy(commandBuffer, buffer, range); });
+}
+
+void BufferManager::upload(DeviceImage& image, const vk::ArrayProxy<const vk::BufferImageCopy>& regions) const
+{
+    upload([&](const vk::CommandBuffer& commandBuffer) { copy(commandBuffer, image, regions); });
+}
+
+void BufferManager::upload(const function<void(const vk::CommandBuffer&)>& record) const
 {
     auto commands=device.allocateCommandBuffers(vk::CommandBufferAllocateInfo{
         .commandPool = commandPool,
         .level = vk::CommandBufferLevel::ePrimary,
         .commandBufferCount = 1
     });
-    auto& copy=commands.front();
-    copy.begin(vk::CommandBufferBeginInfo { .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
-    copy.copyBuffer(stagingBuffer, buffer, range);
-    copy.end();
+    auto& commandBuffer=commands.front();
+    commandBuffer.begin(vk::CommandBufferBeginInfo { .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+    record(commandBuffer);
+    commandBuffer.end();
     auto submitInfo=vk::SubmitInfo{
         .commandBufferCount=1,
-        .pCommandBuffers=&*copy
+        .pCommandBuffers=&*commandBuffer
     };
     transferQueue.submit(submitInfo, fence);
     if (device.waitForFences({fence}, true, numeric_limits<uint64_t>::max()) != vk::Result::eSuccess)
-        throw std::runtime_error("Host to device buffer transfer timed out");
+        throw std::runtime_error("Host to device transfer timed out");
     device.resetFences({fence});
 }
 
-void BufferManager::upload(DeviceImage& image, const vk::BufferImageCopy& region) const
+void BufferManager::copy(const vk::CommandBuffer& commandBuffer, const vk::Buffer& buffer, const vk::BufferCopy& range) const
 {
-    auto commands=device.allocateCommandBuffers(vk::CommandBufferAllocateInfo{
-        .commandPool = commandPool,
-        .level = vk::CommandBufferLevel::ePrimary,
-        .commandBufferCount = 1
-    });
-    auto& copy=commands.front();
-    copy.begin(vk::CommandBufferBeginInfo { .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+    commandBuffer.copyBuffer(stagingBuffer, buffer, range);
+}
 
-    image.discardAndTransition(copy, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite, vk::ImageLayout::eTransferDstOptimal);
-    copy.copyBufferToImage(stagingBuffer, image, vk::ImageLayout::eTransferDstOptimal, region);
-    image.transition(copy, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead, vk::ImageLayout::eShaderReadOnlyOptimal);
-    copy.end();
-    auto submitInfo=vk::SubmitInfo{
-        .commandBufferCount=1,
-        .pCommandBuffers=&*copy
-    };
-    transferQueue.submit(submitInfo, fence);
-    if (device.waitForFences({fence}, true, numeric_limits<uint64_t>::max()) != vk::Result::eSuccess)
-        throw std::runtime_error("Host to device image transfer timed out");
-    device.resetFences({fence});
+void BufferManager::copy(const vk::CommandBuffer& commandBuffer, DeviceImage& image, const vk::ArrayProxy<const vk::BufferImageCopy>& regions) const
+{
+    image.discardAndTransition(commandBuffer, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite, vk::ImageLayout::eTransferDstOptimal);
+    commandBuffer.copyBufferToImage(stagingBuffer, image, vk::ImageLayout::eTransferDstOptimal, regions);
+    image.transition(commandBuffer, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead, vk::ImageLayout::eShaderReadOnlyOptimal);
 }
 
 
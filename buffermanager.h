@@ -39,6 +39,9 @@ struct ImageDescription
 {
     vk::Extent2D extent;
     vk::Format format;
+    uint32_t mipLevels = 1;
+
+    bool operator==(const ImageDescription& rhs) const = default;
 };
 
 class DeviceImage
@@ -87,6 +90,21 @@ public:
         createBarrier(commandBuffer, vk::PipelineStageFlagBits2::eNone, dstStageMask, vk::AccessFlagBits2::eNone, dstAccessMask, vk::ImageLayout::eUndefined, dstLayout);
     }
 
+    //! @brief the barrier from the state the last one left the image in, for recording
+    //! the barriers of several images with one pipelineBarrier2 (see FrameGraph). The
+    //! image assumes it gets recorded. Discarding drops the content, but unlike
+    //! discardAndTransition still waits for earlier accesses.
+    [[nodiscard]] vk::ImageMemoryBarrier2 getTransition(
+        vk::PipelineStageFlags2 dstStageMask,
+        vk::AccessFlags2 dstAccessMask,
+        vk::ImageLayout dstLayout,
+        bool discard
+    );
+
+    //! whether the last access changed the image
+    [[nodiscard]] bool isWritten() const noexcept;
+    inline vk::ImageLayout getLayout() const noexcept { return currentLayout; }
+
 private:
     ImageDescription description;
 
@@ -168,7 +186,13 @@ public:
     }
     
     void upload(const vk::Buffer& buffer, const vk::BufferCopy& range) const;
-    void upload(DeviceImage& image, const vk::BufferImageCopy& region) const;
+    void upload(DeviceImage& image, const vk::ArrayProxy<const vk::BufferImageCopy>& regions) const;
+    //! several copies out of the staging buffer in one submission, so there is only one wait.
+    //! record gets the command buffer to pass to copy.
+    void upload(const function<void(const vk::CommandBuffer&)>& record) const;
+    void copy(const vk::CommandBuffer& commandBuffer, const vk::Buffer& buffer, const vk::BufferCopy& range) const;
+    //! leaves the image ready for sampling in fragment shaders
+    void copy(const vk::CommandBuffer& commandBuffer, DeviceImage& image, const vk::ArrayProxy<const vk::BufferImageCopy>& regions) const;
 
 private:
     vma::Allocator allocator;
@@ -0,0 +1,102 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#pragma once
+
+#include "common.h"
+#include <glm/glm.hpp>
+#include <optional>
+
+//! @brief first contact of a moving circle with something
+struct Contact
+{
+    float time;         // fraction of the movement until the contact, 0..1
+    glm::vec2 normal;   // surface normal at the contact, pointing towards the circle
+    glm::vec2 point;    // contact point on the surface
+};
+
+//! @brief swept circle against an axis aligned box.
+//! Finds the first time the circle touches the box while moving by movement,
+//! i.e. a ray cast against the box grown by radius with rounded corners.
+//! A circle that already overlaps the box counts as a contact at time 0, but
+//! only while it moves further into the box, so a circle that has just been
+//! reflected is free to leave.
+inline optional<Contact> sweepCircleBox(
+    const glm::vec2& pos,
+    const glm::vec2& movement,
+    float radius,
+    const glm::vec2& center,
+    const glm::vec2& halfSize
+)
+{
+    glm::vec2 rel=pos-center;   // work relative to the box center
+
+    // already touching?
+    glm::vec2 closest=glm::clamp(rel, -halfSize, halfSize);
+    glm::vec2 away=rel-closest;
+    float distance2=glm::dot(away, away);
+    if (distance2<radius*radius)
+    {
+        glm::vec2 normal;
+        if (distance2>0.0f) normal=away/sqrtf(distance2);
+        else
+        {
+            // center is inside the box, leave along the axis of least penetration
+            auto penetration=halfSize-glm::abs(rel);
+            if (penetration.x<penetration.y) normal={ rel.x<0.0f ? -1.0f : 1.0f, 0.0f };
+            else normal={ 0.0f, rel.y<0.0f ? -1.0f : 1.0f };
+        }
+        if (glm::dot(movement, normal)>=0.0f) return nullopt;
+        return Contact{ 0.0f, normal, center+closest };
+    }
+
+    // slab test against the grown box
+    glm::vec2 grown=halfSize+radius;
+    float enter=-numeric_limits<float>::max();
+    float exit=1.0f;
+    glm::vec2 normal={ 0.0f, 0.0f };
+    for (int axis=0; axis<2; ++axis)
+    {
+        if (fabs(movement[axis])<1e-9f)
+        {
+            if (fabs(rel[axis])>grown[axis]) return nullopt;
+            continue;
+        }
+        float near=(movement[axis]>0.0f ? -grown[axis] : grown[axis])-rel[axis];
+        float far=(movement[axis]>0.0f ? grown[axis] : -grown[axis])-rel[axis];
+        float tNear=near/movement[axis];
+        float tFar=far/movement[axis];
+        if (tNear>enter)
+        {
+            enter=tNear;
+            normal={ 0.0f, 0.0f };
+            normal[axis]=movement[axis]>0.0f ? -1.0f : 1.0f;
+        }
+        exit=min(exit, tFar);
+        if (enter>exit) return nullopt;
+    }
+    if (exit<=0.0f) return nullopt;    // box is behind us
+
+    // starting inside the grown box is only possible in its corner regions, otherwise
+    // we would overlap and have been handled above (barring rounding at the edge)
+    bool inside=enter<0.0f;
+    enter=max(enter, 0.0f);
+
+    // the grown box has rounded corners, so in the corner regions test the corner circle instead
+    glm::vec2 hit=rel+movement*enter;
+    if (fabs(hit.x)>halfSize.x && fabs(hit.y)>halfSize.y)
+    {
+        glm::vec2 corner={ copysign(halfSize.x, hit.x), copysign(halfSize.y, hit.y) };
+        glm::vec2 m=rel-corner;
+        float a=glm::dot(movement, movement);
+        float b=glm::dot(m, movement);
+        float c=glm::dot(m, m)-radius*radius;
+        float discriminant=b*b-a*c;
+        if (discriminant<0.0f || a==0.0f) return nullopt;
+        float t=(-b-sqrtf(discriminant))/a;
+        if (t<0.0f || t>1.0f) return nullopt;
+        return Contact{ t, glm::normalize(m+movement*t), center+corner };
+    }
+    if (inside || glm::dot(movement, normal)>=0.0f) return nullopt;
+    return Contact{ enter, normal, center+glm::clamp(hit, -halfSize, halfSize) };
+}
@@ -5,6 +5,15 @@
 
 #include "common.h"
 
+#ifndef FRAMES_IN_FLIGHT
+#define FRAMES_IN_FLIGHT 2
+#endif
+
+//! frames the CPU may record ahead of the GPU, chosen with the FRAMES_IN_FLIGHT CMake option.
+//! One frame in flight has the least latency, three keep the GPU busiest.
+constexpr size_t FramesInFlight = FRAMES_IN_FLIGHT;
+static_assert(FramesInFlight>=1 && FramesInFlight<=3, "FRAMES_IN_FLIGHT must be 1, 2 or 3");
+
 template<typename T, size_t HistorySize>
 class DynamicResource
 {
@@ -33,8 +42,14 @@ public:
     inline constexpr const T& current() const noexcept { return values[index]; }
     inline constexpr T& current() noexcept { return values[index]; }
     inline void cycle() const noexcept { index=(index+1)%HistorySize; }
+    inline constexpr size_t getIndex() const noexcept { return index; }
+    static constexpr size_t size() noexcept { return HistorySize; }
 
 private:
     array<T, HistorySize> values;
     mutable size_t index;
-};
\ No newline at end of file
+};
+
+//! one T for every frame in flight, cycled along with the frames
+template<typename T>
+using PerFrame = DynamicResource<T, FramesInFlight>;
@@ -6,6 +6,7 @@
 #include "vulkan.h"
 #include "vkutils.h"
 #include "pipelinebuilder.h"
+#include "profiler.h"
 
 namespace
 {
@@ -19,6 +20,14 @@ namespace
     {
         uint32_t x,y,width,height;
     };
+
+    DescriptorSetBuilder getDescriptorBuilder()
+    {
+        DescriptorSetBuilder builder;
+        builder.bindings.emplace_back(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex);
+        builder.bindings.emplace_back(1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment);
+        return builder;
+    }
 }
 
 Font::Font(const filesystem::path& filename) :
@@ -41,7 +50,7 @@ Font::Font(const filesystem::path& filename) :
         { .extent = { 1024, 1024}, .format = vk::Format::eR8Unorm},
         vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst
     )),
-    sampler(createSampler(vulkan.getPhysicalDevice(), vulkan.getDevice())),
+    sampler(vulkan.getRegistry().getSampler()),
     ft(nullptr),
     face(nullptr)
 
@@ -54,39 +63,21 @@ Font::Font(const filesystem::path& filename) :
         throw runtime_error("ERROR::FREETYPE: Failed to load font '"+filename.string()+"'");  
     }
 
-    DescriptorSetBuilder descBuilder;
-    descBuilder.bindings.emplace_back(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex);
-    descBuilder.bindings.emplace_back(1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment);
-    tie(descriptorLayout, descriptorPool, descriptors)=descBuilder.buildLayoutAndSets(vulkan.getDevice(), 1);
+    auto& registry=vulkan.getRegistry();
+    descriptorLayout=registry.getDescriptorSetLayout(getDescriptorBuilder());
 
     PipelineLayoutBuilder layoutBuilder;
     layoutBuilder.descriptorSets.push_back(descriptorLayout);
     layoutBuilder.pushConstants.emplace_back(vk::ShaderStageFlagBits::eVertex, 0, sizeof(CharacterPushData));
-    pipelineLayout=layoutBuilder.build(vulkan.getDevice());
-
-    PipelineBuilder builder;
-    builder.vertexInputBindings.emplace_back(0, sizeof(GlyphVertex), vk::VertexInputRate::eVertex);
-    builder.vertexInputAttributes.emplace_back(0, 0, vk::Format::eR32G32Sfloat, offsetof(GlyphVertex, pos));
-    builder.vertexInputAttributes.emplace_back(1, 0, vk::Format::eR32G32Sfloat, offsetof(GlyphVertex, texcoord));
+    pipelineLayout=registry.getPipelineLayout(layoutBuilder);
 
-    auto shaderModule=loadShaderModule(vulkan.getDevice(), "shaders/text.spv");        
-    builder.shaders.push_back({ .stage=vk::ShaderStageFlagBits::eVertex, .module=shaderModule, .pName="vertMain"});
-    builder.inputAssembly.topology = vk::PrimitiveTopology::eTriangleStrip;
-    builder.shaders.push_back({ .stage=vk::ShaderStageFlagBits::eFragment, .module=shaderModule, .pName="fragMain"});
-
-    builder.multisample.rasterizationSamples = vk::SampleCountFlagBits::e4;
+    setSamples(vk::SampleCountFlagBits::e4);
+    createDescriptors();
+}
 
-    builder.addColorAttachment(
-        vulkan.getSwapChainFormat().format,
-        vk::PipelineColorBlendAttachmentState{
-            .blendEnable = true,
-            .colorBlendOp = vk::BlendOp::eAdd,
-            .srcColorBlendFactor = vk::BlendFactor::eSrcAlpha,
-            .dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
-            .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB
-        }
-    );
-    pipeline = builder.build(vulkan.getDevice(),pipelineLayout);
+void Font::createDescriptors()
+{
+    tie(descriptorPool, descriptors)=getDescriptorBuilder().buildPoolAndSets(vulkan.getDevice(), descriptorLayout, 1);
 
     auto constantInfo = vk::DescriptorBufferInfo
     {
@@ -119,7 +110,34 @@ Font::Font(const filesystem::path& filename) :
         }
     };
     vulkan.getDevice().updateDescriptorSets(descriptorWrites, {});
+}
+
+void Font::setSamples(vk::SampleCountFlagBits samples)
+{
+    auto& registry=vulkan.getRegistry();
+    PipelineBuilder builder;
+    builder.vertexInputBindings.emplace_back(0, sizeof(GlyphVertex), vk::VertexInputRate::eVertex);
+    builder.vertexInputAttributes.emplace_back(0, 0, vk::Format::eR32G32Sfloat, offsetof(GlyphVertex, pos));
+    builder.vertexInputAttributes.emplace_back(1, 0, vk::Format::eR32G32Sfloat, offsetof(GlyphVertex, texcoord));
 
+    auto shaderModule=registry.getShaderModule("shaders/text.spv");        
+    builder.shaders.push_back({ .stage=vk::ShaderStageFlagBits::eVertex, .module=shaderModule, .pName="vertMain"});
+    builder.inputAssembly.topology = vk::PrimitiveTopology::eTriangleStrip;
+    builder.shaders.push_back({ .stage=vk::ShaderStageFlagBits::eFragment, .module=shaderModule, .pName="fragMain"});
+
+    builder.multisample.rasterizationSamples = samples;
+
+    builder.addColorAttachment(
+        vulkan.getSwapChainFormat().format,
+        vk::PipelineColorBlendAttachmentState{
+            .blendEnable = true,
+            .colorBlendOp = vk::BlendOp::eAdd,
+            .srcColorBlendFactor = vk::BlendFactor::eSrcAlpha,
+            .dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
+            .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB
+        }
+    );
+    pipeline = registry.getPipeline(builder, pipelineLayout);
 }
 
 Font::~Font()
@@ -177,36 +195,38 @@ void Font::resize(const glm::mat4& transformation, const vk::Extent2D& screenSiz
         glyphAdvances[c] = ceil(float(face->glyph->advance.x)/(64.0f*pixelDensityX));
     }
 
-    // Step 2: adapt texture if necessary
-    if (posY+lineHeight > texSize.height)
-    {
-        atlas = vulkan.getBufferManager().createImage(
-            { .extent = { texSize.width, posY+lineHeight }, .format = vk::Format::eR8Unorm},
-            vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst
-        );
-        texSize=atlas.getDescription().extent;
-
-        auto imageInfo = vk::DescriptorImageInfo
-        {
-            .sampler = sampler,
-            .imageView = atlas,
-            .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
-        };
+    // Step 2: frames in flight still draw with the old buffers, atlas and descriptors,
+    // so everything is made anew and the old ones live on until those frames are done
+    auto& bufferManager=vulkan.getBufferManager();
+    texSize.height=max(texSize.height, posY+lineHeight);
+    vulkan.retire(pair(std::move(descriptorPool), std::move(descriptors)));
+    vulkan.retire(std::move(vertices));
+    vulkan.retire(std::move(constants));
+    vulkan.retire(std::move(atlas));
+    vertices=bufferManager.createBuffer(
+        sizeof(GlyphVertex)*4*256,
+        vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        false
+    );
+    constants=bufferManager.createBuffer(
+        sizeof(glm::mat4),
+        vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        false
+    );
+    atlas=bufferManager.createImage(
+        { .extent = texSize, .format = vk::Format::eR8Unorm},
+        vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst
+    );
+    createDescriptors();
 
-        std::array descriptorWrites{
-            vk::WriteDescriptorSet{
-                .dstSet=descriptors[0],
-                .dstBinding=1,
-                .descriptorCount=1,
-                .descriptorType=vk::DescriptorType::eCombinedImageSampler,
-                .pImageInfo=&imageInfo
-            }
-        };
-        vulkan.getDevice().updateDescriptorSets(descriptorWrites, {});
-    }
+    // everything goes to the stage side by side and is uploaded in one go
+    const size_t verticesSize=4*256*sizeof(GlyphVertex);
+    const size_t constantsOffset=verticesSize;
+    const size_t atlasOffset=constantsOffset+sizeof(glm::mat4);
+    byte* stage=static_cast<byte*>(bufferManager.getStage(0, atlasOffset+size_t(texSize.width)*texSize.height));
+    memset(stage+atlasOffset, 0, size_t(texSize.width)*texSize.height);
 
     // Step 3: fill vertex buffer
-    vulkan.getBufferManager().resizeStage(4*256*sizeof(GlyphVertex));
     for (FT_ULong c = 0; c < 256; ++c)
     {
         float left = float(face->glyph->bitmap_left)/pixelDensityX;
@@ -225,12 +245,10 @@ void Font::resize(const glm::mat4& transformation, const vk::Extent2D& screenSiz
             { glm::vec2{left, bottom}, glm::vec2{texLeft, texBottom} },
             { glm::vec2{right, bottom}, glm::vec2{texRight, texBottom} }
         };
-        memcpy(vulkan.getBufferManager().getStage(c*sizeof(quad), sizeof(quad)), quad, sizeof(quad));
+        memcpy(stage+c*sizeof(quad), quad, sizeof(quad));
     }
-    vulkan.getBufferManager().upload(vertices, vk::BufferCopy{.size=4*256*sizeof(GlyphVertex)});
 
     // Step 4: render glyphs into texture and setup texture coordinates
-    byte* stage=static_cast<byte*>(vulkan.getBufferManager().getStage(0, texSize.width * texSize.height));
     for (FT_ULong c = 0; c < 256; ++c)
     {
         // load character glyph 
@@ -238,24 +256,31 @@ void Font::resize(const glm::mat4& transformation, const vk::Extent2D& screenSiz
 
         for (size_t row=0; row<face->glyph->bitmap.rows; ++row)
         {
-            memcpy(stage+texSize.width*(glyphs[c].y+row)+glyphs[c].x,face->glyph->bitmap.buffer+row*face->glyph->bitmap.pitch, glyphs[c].width);
+            memcpy(stage+atlasOffset+texSize.width*(glyphs[c].y+row)+glyphs[c].x,face->glyph->bitmap.buffer+row*face->glyph->bitmap.pitch, glyphs[c].width);
         }
     }
-    vulkan.getBufferManager().upload(
-        atlas,
-        vk::BufferImageCopy{
-            .imageExtent = { texSize.width, texSize.height, 1 },
-            .imageSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 }
-        });
 
     // Step 5: update our constants
-    memcpy(vulkan.getBufferManager().getStage(0, sizeof(glm::mat4)), &transformation, sizeof(transformation));
-    vulkan.getBufferManager().upload(constants, vk::BufferCopy{.size=sizeof(glm::mat4)});
-
+    memcpy(stage+constantsOffset, &transformation, sizeof(transformation));
+
+    bufferManager.upload([&](const vk::CommandBuffer& commandBuffer) {
+        bufferManager.copy(commandBuffer, vertices, vk::BufferCopy{.size=verticesSize});
+        bufferManager.copy(commandBuffer, constants, vk::BufferCopy{.srcOffset=constantsOffset, .size=sizeof(glm::mat4)});
+        bufferManager.copy(
+            commandBuffer,
+            atlas,
+            vk::BufferImageCopy{
+                .bufferOffset = atlasOffset,
+                .imageSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+                .imageExtent = { texSize.width, texSize.height, 1 }
+            });
+    });
 }
 
-void Font::renderText(const vk::CommandBuffer& buffer, const glm::vec2& baselinePos, const std::string& ascii) const
+void Font::renderText(const vk::CommandBuffer& commandBuffer, const glm::vec2& baselinePos, const std::string& ascii) const
 {
+    PROFILE_ZONE("Font::renderText");
+    CountingCommandBuffer buffer(commandBuffer, Profiler::Text);
     buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
     buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, *descriptors[0], {});
     buffer.bindVertexBuffers(0, {vertices}, {0});
@@ -17,6 +17,8 @@ public:
     ~Font();
 
     void resize(const glm::mat4& transformation, const vk::Extent2D& screenSize, float emSizeInDisplayUnits);
+    //! selects the pipeline for render targets with this many samples
+    void setSamples(vk::SampleCountFlagBits samples);
     void renderText(const vk::CommandBuffer& buffer, const glm::vec2& baselinePos, const std::string& ascii) const;
 
 private:
@@ -25,16 +27,19 @@ private:
         glm::vec2 position=glm::vec2(0.0f, 0.0f);
     };
 
-    vk::raii::PipelineLayout pipelineLayout;
-    vk::raii::Pipeline pipeline;
-    vk::raii::DescriptorSetLayout descriptorLayout;
+    //! for the current constants and atlas
+    void createDescriptors();
+
+    vk::PipelineLayout pipelineLayout;      // shared through PipelineRegistry
+    vk::Pipeline pipeline;
+    vk::DescriptorSetLayout descriptorLayout;
     vk::raii::DescriptorPool descriptorPool;
     vk::raii::DescriptorSets descriptors;
 
     DeviceBuffer constants, vertices;
     DeviceImage atlas;
     array<float,256> glyphAdvances;
-    vk::raii::Sampler sampler;
+    vk::Sampler sampler;
 
     FT_Library ft;
     FT_Face face;
@@ -0,0 +1,237 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+
+#include "framegraph.h"
+#include "vulkan.h"
+#include "profiler.h"
+
+namespace
+{
+    struct ImageState
+    {
+        vk::PipelineStageFlags2 stage;
+        vk::AccessFlags2 access;
+        vk::ImageLayout layout;
+    };
+
+    ImageState getState(FrameGraph::Usage usage)
+    {
+        switch (usage)
+        {
+        case FrameGraph::Usage::ColorAttachment:
+            // blending reads the attachment as well
+            return { vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite, vk::ImageLayout::eColorAttachmentOptimal };
+        case FrameGraph::Usage::Sampled:
+            return { vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead, vk::ImageLayout::eShaderReadOnlyOptimal };
+        case FrameGraph::Usage::TransferSrc:
+            return { vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferRead, vk::ImageLayout::eTransferSrcOptimal };
+        case FrameGraph::Usage::TransferDst:
+            return { vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferWrite, vk::ImageLayout::eTransferDstOptimal };
+        }
+        throw runtime_error("unknown frame graph usage");
+    }
+
+    vk::ImageUsageFlags getImageUsage(FrameGraph::Usage usage)
+    {
+        switch (usage)
+        {
+        case FrameGraph::Usage::ColorAttachment: return vk::ImageUsageFlagBits::eColorAttachment;
+        case FrameGraph::Usage::Sampled: return vk::ImageUsageFlagBits::eSampled;
+        case FrameGraph::Usage::TransferSrc: return vk::ImageUsageFlagBits::eTransferSrc;
+        case FrameGraph::Usage::TransferDst: return vk::ImageUsageFlagBits::eTransferDst;
+        }
+        throw runtime_error("unknown frame graph usage");
+    }
+}
+
+FrameGraph::PassBuilder::PassBuilder(FrameGraph& graph, size_t pass) :
+    graph(graph),
+    pass(pass)
+{
+}
+
+void FrameGraph::PassBuilder::read(Resource resource, Usage usage)
+{
+    if (resource==None) return;
+    graph.passes[pass].accesses.emplace_back(resource, usage, false);
+    graph.resources[resource].usage|=getImageUsage(usage);
+}
+
+void FrameGraph::PassBuilder::write(Resource resource, Usage usage)
+{
+    if (resource==None) return;
+    graph.passes[pass].accesses.emplace_back(resource, usage, true);
+    graph.resources[resource].usage|=getImageUsage(usage);
+}
+
+FrameGraph::FrameGraph() :
+    passes(),
+    resources(),
+    pool()
+{
+}
+
+void FrameGraph::reset()
+{
+    passes.clear();
+    resources.clear();
+}
+
+FrameGraph::Resource FrameGraph::importImage(const char* name, DeviceImage& image, bool output)
+{
+    resources.push_back({ .name=name, .image=&image, .output=output });
+    return Resource(resources.size()-1);
+}
+
+FrameGraph::Resource FrameGraph::createTransient(const char* name, const ImageDescription& description, vk::SampleCountFlagBits samples)
+{
+    resources.push_back({ .name=name, .image=nullptr, .output=false, .description=description, .samples=samples });
+    return Resource(resources.size()-1);
+}
+
+void FrameGraph::addPass(const char* name, const Setup& setup, Execute execute)
+{
+    passes.push_back({ .name=name, .accesses={}, .execute=std::move(execute) });
+    PassBuilder builder(*this, passes.size()-1);
+    setup(builder);
+}
+
+void FrameGraph::execute(const vk::CommandBuffer& commandBuffer)
+{
+    cullPasses();
+    assignTransients();
+    for (auto&& pass : passes)
+    {
+        if (!pass.alive) continue;
+        PROFILE_GPU_ZONE(commandBuffer, pass.name);
+        recordBarriers(commandBuffer, pass);
+        pass.execute(commandBuffer);
+    }
+}
+
+DeviceImage& FrameGraph::getImage(Resource resource)
+{
+    auto& r=resources[resource];
+    return r.image ? *r.image : pool[r.poolEntry].image;
+}
+
+void FrameGraph::cullPasses()
+{
+    // going backwards a pass is needed when it writes what is needed after it. Its
+    // writes replace the images, so before the pass only what it reads is needed.
+    vector<bool> needed(resources.size());
+    for (size_t i=0; i<resources.size(); ++i) needed[i]=resources[i].output;
+    for (auto pass=passes.rbegin(); pass!=passes.rend(); ++pass)
+    {
+        pass->alive=ranges::any_of(pass->accesses, [&needed](const Access& a) { return a.write && needed[a.resource]; });
+        if (!pass->alive) continue;
+        for (auto&& a : pass->accesses) if (a.write) needed[a.resource]=false;
+        for (auto&& a : pass->accesses) if (!a.write) needed[a.resource]=true;
+    }
+}
+
+void FrameGraph::assignTransients()
+{
+    // the frames in flight are long done with images idle for that long
+    for (auto& entry : pool)
+    {
+        ++entry.idleFrames;
+        entry.busyUntil=0;
+    }
+    erase_if(pool, [](const PoolEntry& entry) { return entry.idleFrames>MaxIdleFrames; });
+
+    vector<Resource> transients;
+    for (Resource i=0; i<resources.size(); ++i)
+    {
+        auto& r=resources[i];
+        if (r.image) continue;
+        r.firstPass=passes.size();
+        r.lastPass=0;
+        for (size_t p=0; p<passes.size(); ++p)
+        {
+            if (!passes[p].alive) continue;
+            if (ranges::any_of(passes[p].accesses, [i](const Access& a) { return a.resource==i; }))
+            {
+                r.firstPass=min(r.firstPass, p);
+                r.lastPass=max(r.lastPass, p);
+            }
+        }
+        if (r.firstPass<=r.lastPass) transients.push_back(i);
+    }
+
+    // in order of first use, an image is free again after the last pass of its previous user
+    ranges::sort(transients, {}, [this](Resource i) { return resources[i].firstPass; });
+    for (auto i : transients)
+    {
+        auto& r=resources[i];
+        // attachments only used within passes don't need memory of their own on tilers
+        auto usage=r.usage;
+        if (!(usage & ~(vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment)))
+            usage|=vk::ImageUsageFlagBits::eTransientAttachment;
+
+        auto entry=ranges::find_if(pool, [&](const PoolEntry& e) {
+            return e.description==r.description && e.samples==r.samples && e.usage==usage && e.busyUntil<=r.firstPass;
+        });
+        if (entry==pool.end())
+        {
+            pool.push_back({
+                .description=r.description,
+                .samples=r.samples,
+                .usage=usage,
+                .image=vulkan.getBufferManager().createImage(r.description, usage, r.samples)
+            });
+            entry=pool.end()-1;
+        }
+        entry->idleFrames=0;
+        entry->busyUntil=r.lastPass+1;
+        r.poolEntry=size_t(entry-pool.begin());
+    }
+}
+
+void FrameGraph::recordBarriers(const vk::CommandBuffer& commandBuffer, const Pass& pass)
+{
+    vector<vk::ImageMemoryBarrier2> barriers;
+    for (auto&& a : pass.accesses)
+    {
+        auto& image=getImage(a.resource);
+        auto state=getState(a.usage);
+        // reading again what was read before in the same layout needs no barrier
+        if (!a.write && !image.isWritten() && image.getLayout()==state.layout) continue;
+        barriers.push_back(image.getTransition(state.stage, state.access, state.layout, a.write));
+    }
+    if (barriers.empty()) return;
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setImageMemoryBarriers(barriers));
+}
+
+void FrameGraph::beginRendering(
+    const vk::CommandBuffer& commandBuffer,
+    Resource color,
+    Resource resolve,
+    const vk::Extent2D& extent,
+    const vk::ClearValue& clear
+)
+{
+    auto renderArea=vk::Rect2D(vk::Offset2D(0, 0), extent);
+    auto attachmentInfo = vk::RenderingAttachmentInfo{
+        .imageView = getImage(color),
+        .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+        .resolveMode = resolve!=None ? vk::ResolveModeFlagBits::eAverage : vk::ResolveModeFlagBits::eNone,
+        .resolveImageView = resolve!=None ? vk::ImageView(getImage(resolve)) : vk::ImageView(),
+        .resolveImageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+        .loadOp = vk::AttachmentLoadOp::eClear,
+        .storeOp = resolve!=None ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore,
+        .clearValue = clear
+    };
+
+    auto renderingInfo = vk::RenderingInfo{
+        .renderArea = renderArea,
+        .layerCount = 1,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &attachmentInfo
+    };
+
+    commandBuffer.beginRendering(renderingInfo);
+    commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f));
+    commandBuffer.setScissor(0, renderArea);
+}
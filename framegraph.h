@@ -0,0 +1,135 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#pragma once
+
+#include "common.h"
+#include "buffermanager.h"
+#include "dynamicresource.h"
+
+//! @brief the passes of one frame and the images they use.
+//! Every frame the passes are added again with the images they read and
+//! write, execute then
+//!  - drops the passes nothing that is an output depends on,
+//!  - records the barriers every pass needs in a single pipelineBarrier2,
+//!  - hands out transient images (e.g. MSAA attachments) from a pool. Transients
+//!    with the same description share an image when their passes don't overlap.
+//! A write replaces the whole image, its old content is discarded.
+class FrameGraph
+{
+public:
+    using Resource = uint32_t;
+    static constexpr Resource None = numeric_limits<Resource>::max();
+
+    //! pool images unused for this many frames are released, must be more than the frames in flight
+    static constexpr size_t MaxIdleFrames = 8;
+    static_assert(MaxIdleFrames>FramesInFlight);
+
+    enum class Usage
+    {
+        ColorAttachment,
+        Sampled,            // in fragment shaders
+        TransferSrc,
+        TransferDst
+    };
+
+    class PassBuilder
+    {
+    public:
+        //! accesses to None are ignored, so optional resources need no extra branches
+        void read(Resource resource, Usage usage);
+        void write(Resource resource, Usage usage);
+
+    private:
+        PassBuilder(FrameGraph& graph, size_t pass);
+
+        FrameGraph& graph;
+        size_t pass;
+
+        friend class FrameGraph;
+    };
+
+    using Setup = function<void(PassBuilder&)>;
+    using Execute = function<void(const vk::CommandBuffer&)>;
+
+public:
+    FrameGraph();
+
+    FrameGraph(const FrameGraph& rhs) = delete;
+    FrameGraph& operator=(const FrameGraph& rhs) = delete;
+
+    //! forget the passes and resources of the last frame, the pool keeps its images
+    void reset();
+
+    //! an image that lives outside the graph, its state is kept in the DeviceImage.
+    //! Outputs (e.g. the swapchain image) keep the passes writing them alive.
+    Resource importImage(const char* name, DeviceImage& image, bool output=false);
+    //! an attachment that only lives during this frame
+    Resource createTransient(const char* name, const ImageDescription& description, vk::SampleCountFlagBits samples);
+
+    //! setup declares the accesses right away, execute is called from execute.
+    //! The name is also the pass's GPU profiler zone, it must outlive the frame.
+    void addPass(const char* name, const Setup& setup, Execute execute);
+    void execute(const vk::CommandBuffer& commandBuffer);
+
+    //! only valid while the passes execute
+    DeviceImage& getImage(Resource resource);
+
+    //! dynamic rendering into color, resolved into resolve unless it is None.
+    //! Viewport and scissor cover extent from the top left corner.
+    void beginRendering(
+        const vk::CommandBuffer& commandBuffer,
+        Resource color,
+        Resource resolve,
+        const vk::Extent2D& extent,
+        const vk::ClearValue& clear
+    );
+
+private:
+    struct Access
+    {
+        Resource resource;
+        Usage usage;
+        bool write;
+    };
+
+    struct Pass
+    {
+        const char* name;
+        vector<Access> accesses;
+        Execute execute;
+        bool alive = false;
+    };
+
+    struct ResourceEntry
+    {
+        const char* name;
+        DeviceImage* image;         // null for transients
+        bool output;
+        // transients only
+        ImageDescription description;
+        vk::SampleCountFlagBits samples;
+        vk::ImageUsageFlags usage;  // of all passes
+        size_t firstPass = 0;
+        size_t lastPass = 0;
+        size_t poolEntry = 0;
+    };
+
+    struct PoolEntry
+    {
+        ImageDescription description;
+        vk::SampleCountFlagBits samples;
+        vk::ImageUsageFlags usage;
+        DeviceImage image;
+        size_t idleFrames = 0;
+        size_t busyUntil = 0;       // last pass using it this frame, +1
+    };
+
+    vector<Pass> passes;
+    vector<ResourceEntry> resources;
+    vector<PoolEntry> pool;
+
+    void cullPasses();
+    void assignTransients();
+    void recordBarriers(const vk::CommandBuffer& commandBuffer, const Pass& pass);
+};
@@ -2,64 +2,37 @@
 //!@copyright Copyright (c) 2025
 //! please see LICENSE file in root folder for licensing terms.
 #include "game.h"
-#include "vulkan.h"
-#include <glm/ext/matrix_clip_space.hpp>
-#include <glm/gtc/random.hpp>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/matrix_transform_2d.hpp>
-
-#include <SDL3/SDL_scancode.h>
+#include <cstring>
 
 //! @brief constructor
-Game::Game(const filesystem::path& levels) :
+Game::Game(const filesystem::path& levels, uint64_t seed, JobSystem* jobs) :
+    rng(seed, RandomStreamGameplay),
+    events(),
     state(Active),
-    keys(),
+    input(0),
     fieldTL(FieldPosition),
     fieldBR(FieldPosition+FieldSize),
-    sprites(3, 1024, 16),
-    trail(ceil(TrailEmitsPerSecond*TrailDuration)+1, "textures/trail.png"),
-    brickParts(128,  "textures/fragment.png"),
+    player{ {}, InitialPlayerSize },    // position will be set up when level is initialied
+    balls(),
+    ballsPerLife(1),
+    needsContacts(),
     score(0),
-    nextTrailEmit(0.0f),
-    font("textures/font.ttf")
+    levels(levels),
+    levelIndex(this->levels.size()-1),    // nextLevel wraps around to the first level
+    level(),
+    jobs(jobs),
+    pendingLevel(),
+    levelPrefetch(),
+    levelJobs()
 {
-    for (auto const& dir_entry : std::filesystem::directory_iterator{levels})
-    {
-        if (dir_entry.is_regular_file()) levelList.push_back(dir_entry.path());
-    }
-    if (levelList.empty()) throw runtime_error("Failed to find any levels");
-    ranges::sort(levelList);
-    curLevel=levelList.end();
-
-    auto bg=sprites.getOrCreateTexture("background", "textures/background.png");
-    staticImages.push_back(sprites.createSprite(BackgroundLayer, LogicalSize*0.5f, bg, BackgroundSize));
-    staticImages.push_back(sprites.createSprite(GameLayer, {1,15}, sprites.getOrCreateTexture("frame_left", "textures/frame_left.png"), {2,30}));
-    staticImages.push_back(sprites.createSprite(GameLayer, {15,1}, sprites.getOrCreateTexture("frame_top", "textures/frame_top.png"), {26,2}));
-    staticImages.push_back(sprites.createSprite(GameLayer, {29,15}, sprites.getOrCreateTexture("frame_right", "textures/frame_right.png"), {2,30}));
-
-    auto defaultPaddle = sprites.getOrCreateTexture("paddle","textures/paddle.png");
-    player=sprites.createSprite(
-        GameLayer,
-        {}, // position will be set up when level is initialied
-        defaultPaddle,
-        InitialPlayerSize
-    );
-
-    ball.radius = InitialBallSize;
-    ball.sprite = sprites.createSprite(
-        GameLayer,
-        {}, // position is reset when level starts
-        sprites.getOrCreateTexture("ball", "textures/ball.png"),
-        { ball.radius*2.2f, ball.radius*2.2f }
-    );
-
-    powerupDefinitions.emplace_back(PowerUp::None, defaultPaddle, NeutralPowerupColor, 0.0f, 0.0f);
-    powerupDefinitions.emplace_back(PowerUp::Speed, sprites.getOrCreateTexture("speed", "textures/powerup_speed.png"), GoodPowerupColor, 2.0f, 30.0f);
-    powerupDefinitions.emplace_back(PowerUp::Sticky, sprites.getOrCreateTexture("sticky", "textures/powerup_sticky.png"), GoodPowerupColor, 1.0f, 30.0f);
-    powerupDefinitions.emplace_back(PowerUp::PassThrough, sprites.getOrCreateTexture("passthrough", "textures/powerup_passthrough.png"), GoodPowerupColor, 1.0f, 10.0f);
-    powerupDefinitions.emplace_back(PowerUp::Size, sprites.getOrCreateTexture("increase", "textures/powerup_increase.png"), GoodPowerupColor, 2.0f, 30.0f);
-    powerupDefinitions.emplace_back(PowerUp::Confuse, sprites.getOrCreateTexture("confuse", "textures/powerup_confuse.png"), BadPowerupColor, 1.0f, 5.0f);
-    powerupDefinitions.emplace_back(PowerUp::Chaos, sprites.getOrCreateTexture("chaos", "textures/powerup_chaos.png"), BadPowerupColor, 1.0f, 5.0f);
+    powerupDefinitions.emplace_back(PowerUp::None, 0.0f, 0.0f);
+    powerupDefinitions.emplace_back(PowerUp::Speed, 2.0f, 30.0f);
+    powerupDefinitions.emplace_back(PowerUp::Sticky, 1.0f, 30.0f);
+    powerupDefinitions.emplace_back(PowerUp::PassThrough, 1.0f, 10.0f);
+    powerupDefinitions.emplace_back(PowerUp::Size, 2.0f, 30.0f);
+    powerupDefinitions.emplace_back(PowerUp::Confuse, 1.0f, 5.0f);
+    powerupDefinitions.emplace_back(PowerUp::Chaos, 1.0f, 5.0f);
+    powerupDefinitions.emplace_back(PowerUp::MultiBall, 1.0f, 0.0f);
 
     float sum=0.0f;
     for (auto&& pd : powerupDefinitions) sum+=pd.chance;
@@ -69,200 +42,202 @@ Game::Game(const filesystem::path& levels) :
     activePowerup.type=PowerUp::None;
     activePowerup.timeLeft=0.0f;
 
+    prefetchLevel();
     nextLevel();
-
-    brick=audioManager.loadWavWithVariations("sounds/brick0.wav","sounds/brick1.wav","sounds/brick2.wav");
-    go=audioManager.loadWav("sounds/go.wav");
-    lost=audioManager.loadWav("sounds/lost.wav");
-    paddle=audioManager.loadWavWithVariations("sounds/paddle0.wav","sounds/paddle1.wav");
-    solid=audioManager.loadWav("sounds/solid.wav");
-    wall=audioManager.loadWavWithVariations("sounds/wall0.wav","sounds/wall1.wav","sounds/wall2.wav");
 }
 
 Game::~Game()
-{}
-
-void Game::updateScreenSize(const vk::Extent2D& extent)
 {
-    glm::vec2 screen={extent.width, extent.height};
-
-    float fieldAspect=LogicalSize.x/LogicalSize.y;
-    float screenAspect=screen.x/screen.y;
-
-    glm::vec2 viewport;
-    if (fieldAspect > screenAspect) // field is wider than screen
-    {
-        viewport.x = LogicalSize.x;
-        viewport.y = LogicalSize.x/screenAspect;
-    }
-    else
-    {
-        viewport.x = LogicalSize.y*screenAspect;
-        viewport.y = LogicalSize.y;
-    }
-    glm::vec2 offset=(viewport-LogicalSize)*0.5f;
-
-    auto ortho=glm::orthoRH_ZO(
-        -offset.x, viewport.x-offset.x,
-        -offset.y, viewport.y-offset.y,
-        0.0f, 1.0f);
-    sprites.setLayerTransform(BackgroundLayer, ortho);
-    sprites.setLayerTransform(GameLayer, ortho);
-    sprites.setLayerTransform(ForegroundLayer, ortho);
-    trail.setTransformation(ortho);
-    brickParts.setTransformation(ortho);
-
-    font.resize(ortho, extent, FontSize);
+    finishLevelJobs();
 }
 
-void Game::update(float dt, PostProcess& post)
+void Game::update(float dt)
 {
-    float decay=powf(1.0f-TrailDecayPerSecond,dt);
-
-    trail.update(dt, [dt,decay](auto& p) {
-        p.move(p.velocity*dt);
-        p.rotate(p.angularVelocity*dt);
-        p.velocity*=decay;
-        p.angularVelocity*=decay;
-        p.color.a*=decay;
-    });
-
-    brickParts.update(dt, [dt,decay](auto& p) {
-        p.move(p.velocity*dt);
-        p.rotate(p.angularVelocity*dt);
-        p.velocity.y+=dt*Gravity;
-        p.color.a*=decay;
-    });
-
-
-    updatePowerups(dt,post);
+    updatePowerups(dt);
 
-    if (level->isComplete()) nextLevel();
-
-    if (ball.stuck)
-    {
-        ball.sprite->pos.x=player->pos.x+ball.stickOffset;
-        ball.sprite->pos.y=player->top()-ball.radius;
-    }
-    else
+    if (level->isComplete())
     {
-        updateBall(dt,post);
+        events.push_back({ .type=Event::LevelCompleted });
+        nextLevel();
     }
+
+    stickBalls();
+    updateBalls(dt);
 }
 
-void Game::updateBall(float dt, PostProcess& post)
+void Game::updateBalls(float dt)
 {
-    // move ball 
-    auto& bp=ball.sprite->pos;
-
-    nextTrailEmit+=TrailEmitsPerSecond*dt;
-    while (nextTrailEmit>1.0f)
+    size_t count=balls.size();
+    needsContacts.resize(count);
+
+    // broadphase for all balls at once: a ball whose swept bounds stay clear of the walls,
+    // the paddle and the brick grid can't touch anything this step. These loops only
+    // do arithmetic on the arrays, so the compiler can vectorize them.
+    auto [gridMin, gridMax]=level->getGridArea();
+    glm::vec2 paddleMin=player.pos-player.size*0.5f;
+    glm::vec2 paddleMax=player.pos+player.size*0.5f;
+    const float* x=balls.x.data();
+    const float* y=balls.y.data();
+    const float* vx=balls.vx.data();
+    const float* vy=balls.vy.data();
+    const float* radius=balls.radius.data();
+    const uint8_t* stuck=balls.stuck.data();
+    uint8_t* contacts=needsContacts.data();
+    for (size_t i=0; i<count; ++i)
     {
-        auto ofs=glm::linearRand(-TrailPosVar, TrailPosVar);
-        trail.spawnParticleP(
-            TrailDuration,
-            TrailColor,
-            bp+ofs,
-            glm::linearRand(TrailSizeMin, TrailSizeMax),
-            glm::linearRand(0.0f, float(M_PI)*0.5f),
-            ofs*2.0f,
-            glm::linearRand(-float(M_PI),float(M_PI))*3.0f
-        );
-        nextTrailEmit-=1.0f;
+        float minX=min(x[i], x[i]+vx[i]*dt)-radius[i];
+        float maxX=max(x[i], x[i]+vx[i]*dt)+radius[i];
+        float minY=min(y[i], y[i]+vy[i]*dt)-radius[i];
+        float maxY=max(y[i], y[i]+vy[i]*dt)+radius[i];
+
+        bool walls=(minX<=fieldTL.x) | (maxX>=fieldBR.x) | (minY<=fieldTL.y) | (maxY>=fieldBR.y+2.0f*radius[i]);
+        bool paddle=(minX<=paddleMax.x) & (maxX>=paddleMin.x) & (minY<=paddleMax.y) & (maxY>=paddleMin.y);
+        bool grid=(minX<=gridMax.x) & (maxX>=gridMin.x) & (minY<=gridMax.y) & (maxY>=gridMin.y);
+        contacts[i]=(walls | paddle | grid) & !stuck[i];
     }
 
-    bp += ball.velocity * dt;
-
-    // bounce off of walls
-    if (bp.x <= fieldTL.x+ball.radius)
+    float* px=balls.x.data();
+    float* py=balls.y.data();
+    for (size_t i=0; i<count; ++i)
     {
-        wall->play();
-        reflectBall(true, fieldTL.x+ball.radius);
+        // balls in free flight just move, the others are swept below
+        float free=(!contacts[i] & !stuck[i]) ? dt : 0.0f;
+        px[i]+=vx[i]*free;
+        py[i]+=vy[i]*free;
     }
-    else if (bp.x >= fieldBR.x-ball.radius)
+
+    // narrow phase, backwards so removing a lost ball doesn't skip one
+    auto firstEvent=events.size();
+    for (size_t i=count; i-->0;)
     {
-        wall->play();
-        reflectBall(true, fieldBR.x-ball.radius);
+        if (needsContacts[i] && !moveBall(i, dt)) balls.remove(i);
     }
 
-    if (bp.y <= fieldTL.y+ball.radius)
+    // scoring and powerup drops for the destroyed bricks, in the order they were hit
+    for (auto e=events.begin()+firstEvent; e!=events.end(); ++e)
     {
-        wall->play();
-        reflectBall(false, fieldTL.y+ball.radius);
+        if (e->type!=Event::BrickHit || Level::cellHp(e->cell)!=0) continue;
+
+        auto block=level->getBrick(e->brick, e->cell);
+        score+=block.score;
+        maybeSpawnPowerups(block.pos);
     }
-    else if (bp.y >= fieldBR.y+ball.radius)
+
+    if (balls.empty())
     {
-        lost->play();
+        events.push_back({ .type=Event::BallLost });
         resetPlayer();
-        return;
     }
+}
 
-    // check collision with level and reflect accordingly
-    auto [block, closest, hp, score]=level->getBallCollision(bp, ball.radius);
-    if (block)
+bool Game::moveBall(size_t index, float dt)
+{
+    glm::vec2 pos=balls.pos(index);
+    glm::vec2 velocity=balls.velocity(index);
+    float radius=balls.radius[index];
+    auto reflect=[&velocity](const glm::vec2& normal) { velocity-=2.0f*glm::dot(velocity, normal)*normal; };
+
+    // move the ball from contact to contact until the time step is used up
+    float time=dt;
+    bool lost=false;
+    for (size_t contacts=0; contacts<MaxContactsPerStep && time>0.0f && !lost; ++contacts)
     {
-        if (hp==size_t(-1))
+        auto movement=velocity*time;
+
+        enum { None, Wall, Brick, Paddle, Lost } what=None;
+        Contact first{ 1.0f, {}, {} };
+        size_t brickIndex=0;
+
+        // the walls are planes the ball center can't pass, the bottom one loses the ball
+        auto wall=[&](float p, float limit, float move, glm::vec2 normal, auto kind) {
+            if (glm::dot(movement, normal)>=0.0f) return;   // moving away
+            float t=max((limit-p)/move, 0.0f);              // already behind the wall hits right away
+            if (t<first.time)
+            {
+                first={ t, normal, pos+movement*t-normal*radius };
+                what=kind;
+            }
+        };
+        wall(pos.x, fieldTL.x+radius, movement.x, { 1.0f, 0.0f }, Wall);
+        wall(pos.x, fieldBR.x-radius, movement.x, { -1.0f, 0.0f }, Wall);
+        wall(pos.y, fieldTL.y+radius, movement.y, { 0.0f, 1.0f }, Wall);
+        wall(pos.y, fieldBR.y+radius, movement.y, { 0.0f, -1.0f }, Lost);
+
+        if (auto hit=level->getBallCollision(pos, movement, radius); hit && hit->contact.time<first.time)
         {
-            solid->play();
-            post.shake(0.05);
+            first=hit->contact;
+            brickIndex=hit->brick;
+            what=Brick;
         }
-        else if (hp>0)
+
+        if (auto hit=sweepCircleBox(pos, movement, radius, player.pos, player.size*0.5f); hit && hit->time<first.time)
         {
-           solid->play();
-           explodeBrick(block->color, block->pos, block->size, closest, glm::length(ball.velocity));             
+            first=*hit;
+            what=Paddle;
         }
-        else
+
+        pos+=movement*first.time;
+        time-=time*first.time;
+
+        switch (what)
+        {
+        case None:
+            time=0.0f;
+            break;
+
+        case Lost:
+            lost=true;
+            break;
+
+        case Wall:
+            events.push_back({ .type=Event::WallHit });
+            reflect(first.normal);
+            break;
+
+        case Brick:
         {
-            brick->play();
-            explodeBrick(block->color, block->pos, block->size, closest, glm::length(ball.velocity));
-            this->score+=score;
-            maybeSpawnPowerups(block);
+            level->hitBrick(brickIndex);
+            auto cell=level->getCells()[brickIndex];
+            events.push_back({ .type=Event::BrickHit, .cell=cell, .brick=uint32_t(brickIndex), .point=first.point, .velocity=glm::length(velocity) });
+
+            // pass through only works for bricks that break
+            if ((activePowerup.type!=PowerUp::PassThrough) || Level::cellHp(cell)>0) reflect(first.normal);
+            break;
         }
 
-        if ((activePowerup.type!=PowerUp::PassThrough) || (hp>0))
+        case Paddle:
         {
-            glm::vec2 impactDirection = closest-ball.sprite->pos;
-            // TODO: handle corners better
-            if (fabs(impactDirection.x) > fabs(impactDirection.y))  // reflect horizontally
+            events.push_back({ .type=Event::PaddleHit });
+
+            // always send the ball up, even when it hits the side of the paddle
+            velocity.y=-fabs(velocity.y);
+
+            // check where it hit the board, and change velocity based on where it hit the board
+            float percentage = (first.point.x-player.pos.x) / (player.size.x*0.5f);
+            // then move accordingly
+            float strength = 1.0f;
+            float oldVelocity = glm::length(velocity);
+            velocity.x = InitialBallVelocity.x * percentage * strength; 
+            velocity = glm::normalize(velocity) * oldVelocity;         
+            if (activePowerup.type==PowerUp::Sticky)
             {
-                if (impactDirection.x > 0) reflectBall(true, closest.x-ball.radius);
-                else reflectBall(true, closest.x+ball.radius);
-            }
-            else
-            {
-                if (impactDirection.y > 0) reflectBall(false, closest.y-ball.radius);
-                else reflectBall(false, closest.y+ball.radius);
+                balls.stickOffset[index]=pos.x - player.pos.x;
+                balls.stuck[index]=true;
+                time=0.0f;
             }
+            break;
         }
-    }   
-    
-    // check paddle collision
-    glm::vec2 halfPlayerSize=player->size*0.5f;
-    // find closest point on sprite
-    glm::vec2 playerHitPos=bp-player->pos;    // vector to ball relative to player
-    playerHitPos = glm::clamp(playerHitPos, -halfPlayerSize, halfPlayerSize);   // clamped to player size
-    if (glm::length((playerHitPos+player->pos)-bp) < ball.radius) // hit
-    {
-        paddle->play();
-
-        reflectBall(false, player->pos.y-halfPlayerSize.y-ball.radius);
-
-        // check where it hit the board, and change velocity based on where it hit the board
-        float percentage = playerHitPos.x / halfPlayerSize.x;
-        // then move accordingly
-        float strength = 1.0f;
-        float oldVelocity = glm::length(ball.velocity);
-        ball.velocity.x = InitialBallVelocity.x * percentage * strength; 
-        ball.velocity = glm::normalize(ball.velocity) * oldVelocity;         
-        if (activePowerup.type==PowerUp::Sticky)
-        {
-            ball.stickOffset=ball.sprite->pos.x - player->pos.x;
-            ball.stuck=true;
         }
-    } 
+    }
+
+    balls.x[index]=pos.x;
+    balls.y[index]=pos.y;
+    balls.vx[index]=velocity.x;
+    balls.vy[index]=velocity.y;
+    return !lost;
 }
 
-void Game::updatePowerups(float dt, PostProcess& post)
+void Game::updatePowerups(float dt)
 {
     activePowerup.timeLeft -= dt;
 
@@ -272,19 +247,26 @@ void Game::updatePowerups(float dt, PostProcess& post)
         newPowerUp={PowerUp::None, 0.0f};
     }
 
+    glm::vec2 halfPlayerSize=player.size*0.5f;
+    glm::vec2 halfPowerupSize=PowerupSize*0.5f;
     for (auto&& p : floatingPowerups)
     {
-        p->pos.y+=PowerupFallSpeed*dt;
+        p.pos.y+=PowerupFallSpeed*dt;
 
-        if (p->intersects(*player))
+        auto distance=glm::abs(p.pos-player.pos);
+        if (distance.x<=halfPlayerSize.x+halfPowerupSize.x && distance.y<=halfPlayerSize.y+halfPowerupSize.y)
         {
-            auto&& def=getPowerUpFromTexture(p->texture);
-            newPowerUp.type = def.type;
-            newPowerUp.timeLeft = def.duration;
-            p->pos.y = fieldBR.y+p->size.y;
+            auto&& def=getPowerUpFromType(p.type);
+            if (def.type==PowerUp::MultiBall) splitBalls();
+            else
+            {
+                newPowerUp.type = def.type;
+                newPowerUp.timeLeft = def.duration;
+            }
+            p.pos.y = fieldBR.y+PowerupSize.y;
         }
     }
-    erase_if(floatingPowerups, [limit=fieldBR.y](const auto& p) { return p->top()>limit; });
+    erase_if(floatingPowerups, [limit=fieldBR.y+halfPowerupSize.y](const auto& p) { return p.pos.y>limit; });
 
     if (activePowerup.type == newPowerUp.type)
     {
@@ -294,39 +276,47 @@ void Game::updatePowerups(float dt, PostProcess& post)
     {
         switch (activePowerup.type)
         {
-        case PowerUp::Speed: ball.velocity = glm::normalize(ball.velocity) * glm::length(InitialBallVelocity); break;
-        case PowerUp::Size: player->size = InitialPlayerSize; break;
-        case PowerUp::Confuse: post.confuse(0.0f); break;
-        case PowerUp::Chaos: post.chaos(0.0f); break;
+        case PowerUp::Speed:
+            for (size_t i=0; i<balls.size(); ++i)
+            {
+                auto v=glm::normalize(balls.velocity(i)) * glm::length(InitialBallVelocity);
+                balls.vx[i]=v.x;
+                balls.vy[i]=v.y;
+            }
+            break;
+        case PowerUp::Size: player.size = InitialPlayerSize; break;
         default: break;
         }
 
+        auto previous=activePowerup.type;
         activePowerup.type = newPowerUp.type;
         activePowerup.timeLeft = newPowerUp.timeLeft;
 
         switch (activePowerup.type)
         {
-        case PowerUp::Speed: ball.velocity *= PowerupBallVelocity; break;
-        case PowerUp::Size: player->size = PowerUpPlayerSize; break;
-        case PowerUp::Confuse: post.confuse(activePowerup.timeLeft); break;
-        case PowerUp::Chaos: post.chaos(activePowerup.timeLeft); break;
+        case PowerUp::Speed:
+            for (size_t i=0; i<balls.size(); ++i)
+            {
+                balls.vx[i]*=PowerupBallVelocity;
+                balls.vy[i]*=PowerupBallVelocity;
+            }
+            break;
+        case PowerUp::Size: player.size = PowerUpPlayerSize; break;
         default:break;
         }
 
-        auto&& def = getPowerUpFromType(activePowerup.type);
-        player->texture = def.texture;
-        player->color = def.color;
+        events.push_back({ .type=Event::PowerupChanged, .powerup=uint8_t(activePowerup.type), .previousPowerup=uint8_t(previous) });
     }
 }
 
-void Game::maybeSpawnPowerups(const SpriteManager::Sprite& brick)
+void Game::maybeSpawnPowerups(const glm::vec2& pos)
 {
-    float draw=SDL_randf();
+    float draw=rng.nextFloat();
     for (const auto& pd : powerupDefinitions)
     {
         if (draw<pd.chance)
         {
-            floatingPowerups.emplace_back(sprites.createSprite(BackgroundLayer, brick->pos, pd.texture, PowerupSize, pd.color));
+            floatingPowerups.emplace_back(pd.type, pos);
             return;
         }
         else
@@ -338,20 +328,10 @@ void Game::maybeSpawnPowerups(const SpriteManager::Sprite& brick)
 
 void Game::forceSpawnPowerup(PowerUp::Type type, const glm::vec2& pos)
 {
-    auto&& pd=getPowerUpFromType(type);
-    floatingPowerups.emplace_back(sprites.createSprite(BackgroundLayer, pos, pd.texture, PowerupSize, pd.color));
-}
-
-const Game::PowerUpDefinition& Game::getPowerUpFromTexture(SpriteManager::Texture texture)
-{
-    for (const auto& def : powerupDefinitions)
-    {
-        if (def.texture == texture) return def;
-    }
-    return getPowerUpFromType(PowerUp::None);
+    floatingPowerups.emplace_back(type, pos);
 }
 
-const Game::PowerUpDefinition& Game::getPowerUpFromType(Game::PowerUp::Type type)
+const Game::PowerUpDefinition& Game::getPowerUpFromType(Game::PowerUp::Type type) const
 {
     return powerupDefinitions[static_cast<size_t>(type)];
 }
@@ -360,114 +340,285 @@ void Game::processInput(float dt)
 {
     if (state == Active)
     {
-        if (keys[SDL_SCANCODE_L])
+        if (input & InputNextLevel)
         {
             nextLevel();
-            keys[SDL_SCANCODE_L]=false;
         }
 
-        for (int pu=PowerUp::Speed; pu<=PowerUp::MAX; ++pu)
+        for (int pu=PowerUp::Speed; pu<PowerUp::MAX; ++pu)
         {
-            if (keys[SDL_SCANCODE_1+pu-1])
+            if (input & (InputPowerup<<(pu-1)))
             {
-                forceSpawnPowerup(PowerUp::Type(pu), player->pos);
-                keys[SDL_SCANCODE_1+pu-1]=false;
+                forceSpawnPowerup(PowerUp::Type(pu), player.pos);
             }
         }
 
         float ds = PlayerVelocity * dt;
         // move playerboard
-        if (keys[SDL_SCANCODE_LEFT] || keys[SDL_SCANCODE_A])
+        if (input & InputLeft)
         {
-            player->pos.x = max(player->pos.x-ds, fieldTL.x+player->size.x*0.5f);
+            player.pos.x = max(player.pos.x-ds, fieldTL.x+player.size.x*0.5f);
         }
-        if (keys[SDL_SCANCODE_RIGHT] || keys[SDL_SCANCODE_D])
+        if (input & InputRight)
         {
-            player->pos.x = min(player->pos.x+ds, fieldBR.x-player->size.x*0.5f);
+            player.pos.x = min(player.pos.x+ds, fieldBR.x-player.size.x*0.5f);
         }
 
-        if (keys[SDL_SCANCODE_SPACE] && ball.stuck)
+        if ((input & InputLaunch) && ranges::find(balls.stuck, true)!=balls.stuck.end())
         {
-            ball.stuck=false;
-            keys[SDL_SCANCODE_SPACE]=false;
-            go->play();
+            ranges::fill(balls.stuck, false);
+            events.push_back({ .type=Event::BallLaunched });
         }
     }
 }
 
-void Game::draw(const vk::CommandBuffer& commandBuffer) const
+void Game::splitBalls()
 {
-    sprites.drawLayer(BackgroundLayer, commandBuffer);
-    trail.draw(commandBuffer);
-    sprites.drawLayer(GameLayer, commandBuffer);
-    brickParts.draw(commandBuffer);
-    sprites.drawLayer(ForegroundLayer, commandBuffer);
-
-    font.renderText(commandBuffer, ScoreLabelPos, "SCORE");
-
-    font.renderText(commandBuffer, ScorePos, format("{:05}", score));
+    // every ball in flight gets two companions, one to each side
+    float c=cosf(MultiBallAngle);
+    float s=sinf(MultiBallAngle);
+    size_t count=balls.size();
+    for (size_t i=0; i<count && balls.size()+2<=MaxBalls; ++i)
+    {
+        if (balls.stuck[i]) continue;
+        auto pos=balls.pos(i);
+        auto v=balls.velocity(i);
+        balls.add(pos, { c*v.x-s*v.y, s*v.x+c*v.y }, balls.radius[i], false);
+        balls.add(pos, { c*v.x+s*v.y, -s*v.x+c*v.y }, balls.radius[i], false);
+    }
 }
 
-void Game::reflectBall(bool horizontal, float limit)
+void Game::addBalls(size_t count)
 {
-   auto& bp=ball.sprite->pos;
-    if (horizontal)
+    // launched from the paddle in random upward directions
+    count=min(count, MaxBalls-balls.size());
+    float speed=glm::length(InitialBallVelocity);
+    glm::vec2 pos={ player.pos.x, player.pos.y-player.size.y*0.5f-InitialBallSize };
+    for (size_t i=0; i<count; ++i)
     {
-        ball.velocity.x = -ball.velocity.x;
-        bp.x=2.0f*limit-bp.x;
-    }
-    else
-    {
-        ball.velocity.y = -ball.velocity.y;
-        bp.y=2.0f*limit-bp.y;
+        float angle=rng.range(-float(M_PI)*0.4f, float(M_PI)*0.4f);
+        balls.add(pos, glm::vec2{ sinf(angle), -cosf(angle) }*speed, InitialBallSize, false);
     }
 }
 
 void Game::nextLevel()
 {
-    if (curLevel==levelList.end()) curLevel=levelList.begin();
-    else ++curLevel;
-    if (curLevel==levelList.end()) curLevel=levelList.begin();
-
-    level=make_unique<Level>(*curLevel, FieldPosition, BlockSize, sprites, GameLayer);
+    // usually long done, so switching levels is just handing over the pointer
+    finishLevelJobs();
+    levelIndex=(levelIndex+1)%levels.size();
+    level=std::move(pendingLevel);
+    prefetchLevel();
     resetPlayer();
+    events.push_back({ .type=Event::LevelLoaded });
 }
 
 void Game::resetPlayer()
 {
-    player->pos={(fieldTL.x+fieldBR.x)*0.5f, fieldBR.y-player->size.y};
-    ball.stuck=true;
-    ball.stickOffset=0.0f;
-    ball.velocity=InitialBallVelocity;
+    player.pos={(fieldTL.x+fieldBR.x)*0.5f, fieldBR.y-player.size.y};
+    balls.clear();
+    balls.add({}, InitialBallVelocity, InitialBallSize, true);
+    stickBalls();
+    addBalls(ballsPerLife-1);
 
     floatingPowerups.clear();
     activePowerup.timeLeft=0.0f;
 }
 
-void Game::explodeBrick(
-    const glm::vec4& color,
-    const glm::vec2& brickPos,
-    const glm::vec2& brickSize,
-    const glm::vec2& hitPoint,
-    float velocity
-)
+void Game::stickBalls()
 {
-    for (float y=-0.25f; y<0.5f; y+=0.5f)
+    for (size_t i=0; i<balls.size(); ++i)
     {
-        for (float x=-0.375f; x<0.5f; x+=0.25f)
-        {
-            auto center=brickPos+glm::vec2{x,y}*brickSize;
-            auto dir=glm::normalize(center-hitPoint);
-            brickParts.spawnParticleP(
-                1.0f,
-                color,
-                center,
-                glm::vec2{brickSize.x*0.25f, brickSize.y*0.5f},
-                glm::linearRand(0.0f, float(M_PI)*2.0f),
-                dir*velocity,
-                glm::linearRand(-float(M_PI),float(M_PI))*5.0f
-            );
+        if (!balls.stuck[i]) continue;
+        balls.x[i]=player.pos.x+balls.stickOffset[i];
+        balls.y[i]=player.pos.y-player.size.y*0.5f-balls.radius[i];
+    }
+}
 
-        }
+void Game::Balls::add(const glm::vec2& pos, const glm::vec2& velocity, float r, bool isStuck, float offset)
+{
+    x.push_back(pos.x);
+    y.push_back(pos.y);
+    vx.push_back(velocity.x);
+    vy.push_back(velocity.y);
+    radius.push_back(r);
+    stickOffset.push_back(offset);
+    stuck.push_back(isStuck);
+}
+
+void Game::Balls::remove(size_t i)
+{
+    auto swapRemove=[i](auto& v) {
+        v[i]=v.back();
+        v.pop_back();
+    };
+    swapRemove(x);
+    swapRemove(y);
+    swapRemove(vx);
+    swapRemove(vy);
+    swapRemove(radius);
+    swapRemove(stickOffset);
+    swapRemove(stuck);
+}
+
+void Game::Balls::clear()
+{
+    x.clear();
+    y.clear();
+    vx.clear();
+    vy.clear();
+    radius.clear();
+    stickOffset.clear();
+    stuck.clear();
+}
+
+unique_ptr<Level> Game::loadLevel(size_t index) const
+{
+    auto layout=levels.getLayout(index);
+    auto blockSize=glm::min(BlockSize, glm::vec2{ FieldSize.x/float(layout.columns), MaxBrickAreaHeight/float(layout.rows) });
+    return make_unique<Level>(layout, FieldPosition, blockSize);
+}
+
+void Game::prefetchLevel()
+{
+    auto build=[this, index=(levelIndex+1)%levels.size()]() { pendingLevel=loadLevel(index); };
+    if (jobs) levelPrefetch=jobs->submit(build);
+    else build();
+}
+
+void Game::stageNextLevel(function<void(const Level& next)> task)
+{
+    if (!jobs)
+    {
+        task(*pendingLevel);
+        return;
+    }
+    levelJobs.push_back(jobs->submit([this, task=std::move(task)]() { task(*pendingLevel); }, { levelPrefetch }));
+}
+
+void Game::finishLevelJobs()
+{
+    if (!jobs) return;
+    jobs->wait(levelPrefetch);
+    jobs->wait(levelJobs);
+    levelPrefetch=nullptr;
+    levelJobs.clear();
+}
+
+void Game::finishStagingJobs()
+{
+    if (!jobs) return;
+    jobs->wait(levelJobs);
+    levelJobs.clear();
+}
+
+//! fixed size part of a snapshot, followed by the ball arrays, the floating
+//! powerups and the level cells
+struct Game::SnapshotHeader
+{
+    Random rng;
+    State state;
+    Replay::Input input;
+    Paddle player;
+    PowerUp activePowerup;
+    uint64_t score;
+    uint64_t ballsPerLife;
+    uint64_t levelIndex;
+    uint64_t ballCount;
+    uint64_t floatingCount;
+    uint64_t cellCount;
+};
+
+namespace
+{
+    constexpr size_t BallSnapshotSize = 6*sizeof(float)+sizeof(uint8_t);
+
+    template<typename T>
+    void writeArray(uint8_t*& out, const vector<T>& values) noexcept
+    {
+        memcpy(out, values.data(), values.size()*sizeof(T));
+        out+=values.size()*sizeof(T);
+    }
+
+    template<typename T>
+    void readArray(const uint8_t*& in, vector<T>& values, size_t count)
+    {
+        values.resize(count);
+        memcpy(values.data(), in, count*sizeof(T));
+        in+=count*sizeof(T);
+    }
+}
+
+void Game::save(Snapshot& snapshot) const
+{
+    static_assert(is_trivially_copyable_v<SnapshotHeader> && is_trivially_copyable_v<FloatingPowerUp>);
+
+    auto cells=level->getCells();
+    auto n=balls.size();
+    snapshot.data.resize(sizeof(SnapshotHeader)+n*BallSnapshotSize+floatingPowerups.size()*sizeof(FloatingPowerUp)+cells.size());
+
+    SnapshotHeader header{
+        rng, state, input, player, activePowerup, score, ballsPerLife,
+        levelIndex, n, floatingPowerups.size(), cells.size()
+    };
+    auto out=snapshot.data.data();
+    memcpy(out, &header, sizeof(header));
+    out+=sizeof(header);
+    writeArray(out, balls.x);
+    writeArray(out, balls.y);
+    writeArray(out, balls.vx);
+    writeArray(out, balls.vy);
+    writeArray(out, balls.radius);
+    writeArray(out, balls.stickOffset);
+    writeArray(out, balls.stuck);
+    writeArray(out, floatingPowerups);
+    memcpy(out, cells.data(), cells.size());
+}
+
+void Game::restore(const Snapshot& snapshot)
+{
+    SnapshotHeader header;
+    if (snapshot.data.size()<sizeof(header)) throw runtime_error("Invalid game snapshot");
+    memcpy(&header, snapshot.data.data(), sizeof(header));
+    if (snapshot.data.size()!=sizeof(header)+header.ballCount*BallSnapshotSize+header.floatingCount*sizeof(FloatingPowerUp)+header.cellCount)
+    {
+        throw runtime_error("Invalid game snapshot");
+    }
+    if (header.levelIndex>=levels.size() || header.cellCount!=levels.getLayout(header.levelIndex).cells.size())
+    {
+        throw runtime_error("Game snapshot doesn't match the level pack");
+    }
+
+    auto previousPowerup=activePowerup.type;
+    if (header.levelIndex!=levelIndex)
+    {
+        finishLevelJobs();
+        levelIndex=header.levelIndex;
+        level=loadLevel(levelIndex);
+        prefetchLevel();
+    }
+
+    rng=header.rng;
+    state=header.state;
+    input=header.input;
+    player=header.player;
+    activePowerup=header.activePowerup;
+    score=header.score;
+    ballsPerLife=header.ballsPerLife;
+
+    auto in=snapshot.data.data()+sizeof(header);
+    readArray(in, balls.x, header.ballCount);
+    readArray(in, balls.y, header.ballCount);
+    readArray(in, balls.vx, header.ballCount);
+    readArray(in, balls.vy, header.ballCount);
+    readArray(in, balls.radius, header.ballCount);
+    readArray(in, balls.stickOffset, header.ballCount);
+    readArray(in, balls.stuck, header.ballCount);
+    readArray(in, floatingPowerups, header.floatingCount);
+    level->restore(span(in, header.cellCount));
+
+    if (activePowerup.type!=previousPowerup)
+    {
+        events.push_back({ .type=Event::PowerupChanged, .powerup=uint8_t(activePowerup.type), .previousPowerup=uint8_t(previousPowerup) });
     }
+    events.push_back({ .type=Event::StateRestored });
 }
@@ -4,30 +4,26 @@
 #pragma once
 
 #include "common.h"
-#include "spritemanager.h"
 #include "level.h"
-#include "audiomanager.h"
-#include "particlesystem.h"
-#include "postprocess.h"
-#include "font.h"
-
-//! @brief Game holds all game-related state and functionality.
-//! Combines all game-related data into a single class for
-//! easy access to each of the components and manageability.
+#include "levelpack.h"
+#include "jobsystem.h"
+#include "random.h"
+#include "replay.h"
+#include <glm/glm.hpp>
+
+//! @brief Game holds the complete game state and rules.
+//! It knows nothing about rendering, audio or the window, so any number of
+//! instances can run side by side (see GameView for the presentation and
+//! batch.cpp for headless runs). Everything that should be seen or heard
+//! is collected as Events for the caller to pick up after each tick.
 class Game
 {
 public:
-    static constexpr size_t KeyCount = 1024;
-
-    static constexpr size_t BackgroundLayer = 0;
-    static constexpr size_t GameLayer = 1;
-    static constexpr size_t ForegroundLayer = 2;
-
-    static constexpr glm::vec2 LogicalSize = { 40.0f, 30.0f };
-    static constexpr glm::vec2 BackgroundSize = { 48.0f, 38.0f };
     static constexpr glm::vec2 FieldPosition = { 2.0f, 2.0f };
     static constexpr glm::vec2 FieldSize = { 26.0f, 28.0f };
     static constexpr glm::vec2 BlockSize = { 2.0f, 1.0f };
+    //! bricks shrink below BlockSize when a level wouldn't fit the field otherwise
+    static constexpr float MaxBrickAreaHeight = 20.0f;
 
     static constexpr glm::vec2 InitialBallVelocity = { 10.0f, -10.0f };
     static constexpr float PowerupBallVelocity = 1.2f;
@@ -38,24 +34,18 @@ public:
  
     static constexpr glm::vec2 PowerupSize = { 4.0f, 1.0f }; 
     static constexpr float PowerupFallSpeed = 3.0f;
-    static constexpr glm::vec4 NeutralPowerupColor = { 1.0f, 1.0f, 1.0f, 1.0f };
-    static constexpr glm::vec4 GoodPowerupColor = { 0.5f, 0.5f, 1.0f, 1.0f };
-    static constexpr glm::vec4 BadPowerupColor = { 1.0f, 0.25f, 0.25f, 1.0f };
     static constexpr float PowerupChance=0.1f;
-    
-    static constexpr float TrailDuration = .5f;
-    static constexpr float TrailDecayPerSecond = 0.99f;      
-    static constexpr float TrailEmitsPerSecond = 60.0f;
-    static constexpr glm::vec4 TrailColor = { 1.0f, 1.0f, 0.2f, 1.0f };
-    static constexpr glm::vec2 TrailSizeMin = { 0.2f, 0.2f };
-    static constexpr glm::vec2 TrailSizeMax = { 0.5f, 0.5f };
-    static constexpr glm::vec2 TrailPosVar = { 0.3f, 0.3f };
-    static constexpr float Gravity = 62.0f;
 
-    static constexpr float FontSize = 1.5f;
+    //! contacts resolved per ball and update, the rest of the step is dropped after that
+    static constexpr size_t MaxContactsPerStep = 8;
+
+    static constexpr size_t MaxBalls = 4096;
+    static constexpr float MultiBallAngle = 0.35f;  // radians between the split balls
 
-    static constexpr glm::vec2 ScoreLabelPos = { 31.0f, 4.0f };
-    static constexpr glm::vec2 ScorePos =      { 31.0f, 8.0f };
+    // gameplay and cosmetic effects draw from separate streams, so that
+    // skipping the effects can never change the outcome of a game
+    static constexpr uint64_t RandomStreamGameplay = 0;
+    static constexpr uint64_t RandomStreamEffects = 1;
 
 public:
     enum State
@@ -65,19 +55,41 @@ public:
         Win
     };
 
-    struct Ball
+    //! the input that drives the game, as recorded in replays.
+    //! Everything but left and right are one-shot actions.
+    enum InputBits : Replay::Input
     {
-        SpriteManager::Sprite sprite;
-        bool stuck;
-        float stickOffset;
-        float radius;
-        glm::vec2 velocity;
+        InputLeft = 1<<0,
+        InputRight = 1<<1,
+        InputLaunch = 1<<2,
+        InputNextLevel = 1<<3,
+        InputPowerup = 1<<4     // one bit per powerup type after None
     };
 
-    struct TrailData
+    struct Paddle
     {
-        glm::vec2 velocity;
-        glm::f32 angularVelocity;
+        glm::vec2 pos;
+        glm::vec2 size;
+    };
+
+    //! @brief all balls in play, stored as structure of arrays so the
+    //! per-tick passes over them vectorize
+    struct Balls
+    {
+        vector<float> x, y;
+        vector<float> vx, vy;
+        vector<float> radius;
+        vector<float> stickOffset;
+        vector<uint8_t> stuck;
+
+        inline size_t size() const noexcept { return x.size(); }
+        inline bool empty() const noexcept { return x.empty(); }
+        inline glm::vec2 pos(size_t i) const noexcept { return { x[i], y[i] }; }
+        inline glm::vec2 velocity(size_t i) const noexcept { return { vx[i], vy[i] }; }
+
+        void add(const glm::vec2& pos, const glm::vec2& velocity, float r, bool isStuck, float offset=0.0f);
+        void remove(size_t i);      // moves the last ball into the gap
+        void clear();
     };
 
     struct PowerUp
@@ -91,6 +103,7 @@ public:
             Size,
             Confuse,
             Chaos,
+            MultiBall,      // instant, splits every ball in play
 
 
             MAX
@@ -103,75 +116,143 @@ public:
     struct PowerUpDefinition
     {
         PowerUp::Type type;
-        SpriteManager::Texture texture;
-        glm::vec4 color;
         float chance;
         float duration;
     };
 
+    struct FloatingPowerUp
+    {
+        PowerUp::Type type;
+        glm::vec2 pos;
+    };
+
+    //! @brief something that happened in the game and should be seen or heard.
+    //! The game only appends events, whoever runs the game loop reads them
+    //! after every tick and clears them. Headless runs can just clear them.
+    struct Event
+    {
+        enum Type : uint8_t
+        {
+            LevelLoaded,
+            LevelCompleted,
+            BallLaunched,
+            BallLost,           // the last ball dropped out of the field
+            WallHit,
+            PaddleHit,
+            BrickHit,           // brick, cell, point, velocity
+            PowerupChanged,     // powerup, previousPowerup
+            StateRestored       // a snapshot replaced everything, the level might be a different one
+        };
+
+        Type type;
+        uint8_t powerup = PowerUp::None;
+        uint8_t previousPowerup = PowerUp::None;
+        Level::Cell cell = 0;   // brick cell after the hit, its hp is 0 once it is destroyed
+        uint32_t brick = 0;     // cell index in the current level
+        glm::vec2 point = {};
+        float velocity = 0.0f;
+    };
+
+    //! @brief the complete game state copied into one flat buffer, only
+    //! trivially copyable data. Saving into the same snapshot again reuses
+    //! its memory, so a snapshot can be taken every tick.
+    class Snapshot
+    {
+    public:
+        inline size_t size() const noexcept { return data.size(); }
+
+    private:
+        vector<uint8_t> data;
+
+        friend class Game;
+    };
+
 public:
     // constructor/destructor
-    Game(const filesystem::path& levels);
+    //! levels is a level pack compiled by levelc. With a job system the next
+    //! level is prepared on a worker while the current one is played.
+    Game(const filesystem::path& levels, uint64_t seed, JobSystem* jobs=nullptr);
     ~Game();
 
+    inline const vector<Event>& getEvents() const noexcept { return events; }
+    inline void clearEvents() noexcept { events.clear(); }
+
     // game loop
-    void updateScreenSize(const vk::Extent2D& extent);
     void processInput(float dt);
-    void update(float dt, PostProcess& post);
-    void updateBall(float dt, PostProcess& post);
-    void updatePowerups(float dt, PostProcess& post);
-    void draw(const vk::CommandBuffer& commandBuffer) const;
+    void update(float dt);
+    void updateBalls(float dt);
+    //! sweep one ball through its contacts, returns false if it dropped out of the field
+    bool moveBall(size_t ball, float time);
+    void updatePowerups(float dt);
 
-    void maybeSpawnPowerups(const SpriteManager::Sprite& brick);
+    void maybeSpawnPowerups(const glm::vec2& pos);
     void forceSpawnPowerup(PowerUp::Type type, const glm::vec2& pos);
 
-    const PowerUpDefinition& getPowerUpFromTexture(SpriteManager::Texture texture);
-    const PowerUpDefinition& getPowerUpFromType(PowerUp::Type type);
+    const PowerUpDefinition& getPowerUpFromType(PowerUp::Type type) const;
 
-    inline void setKey(size_t key, bool pressed)
-    {
-        if (key < KeyCount)
-            keys[key] = pressed;
-    }
+    inline Replay::Input getInput() const noexcept { return input; }
+    inline void setInput(Replay::Input in) noexcept { input=in; }
+
+    inline size_t getScore() const noexcept { return score; }
+    inline const Paddle& getPlayer() const noexcept { return player; }
+    inline const Balls& getBalls() const noexcept { return balls; }
+    //! stress test: every life starts with this many balls, all but one already launched
+    inline void setBallsPerLife(size_t count) noexcept { ballsPerLife=clamp<size_t>(count, 1, MaxBalls); }
+    void addBalls(size_t count);
+    inline const PowerUp& getActivePowerup() const noexcept { return activePowerup; }
+    inline const vector<FloatingPowerUp>& getFloatingPowerups() const noexcept { return floatingPowerups; }
+    inline const Level& getLevel() const noexcept { return *level; }
+    inline size_t getLevelIndex() const noexcept { return levelIndex; }
+    inline size_t getLevelCount() const noexcept { return levels.size(); }
+    inline string_view getLevelName() const noexcept { return levels.getName(levelIndex); }
+    inline size_t getMaxBrickCount() const noexcept { return levels.getMaxCellCount(); }
+    //! run task on the next level once it has been prefetched, e.g. to stage
+    //! its sprites. The level isn't touched until the task has finished.
+    void stageNextLevel(function<void(const Level& next)> task);
+    //! wait for the prefetch and all staging tasks
+    void finishLevelJobs();
+    //! wait only for the staging tasks (and the prefetches they depend on), nothing
+    //! to wait for right after a level switch
+    void finishStagingJobs();
+
+    void save(Snapshot& snapshot) const;
+    inline Snapshot save() const { Snapshot s; save(s); return s; }
+    //! the snapshot must come from a game with the same level pack
+    void restore(const Snapshot& snapshot);
 
 private:
+    Random rng;
+    vector<Event> events;
+
     // game state
     State  state;
-    bool   keys[KeyCount];
+    Replay::Input input;
     glm::vec2 fieldTL;
     glm::vec2 fieldBR;
 
-    // draws all our sprites
-    SpriteManager sprites;
-    vector<SpriteManager::Sprite> staticImages;
-    SpriteManager::Sprite player;
-    Ball ball;
-    ParticleSystem<TrailData> trail,brickParts;
+    Paddle player;
+    Balls balls;
+    size_t ballsPerLife;
+    vector<uint8_t> needsContacts;  // scratch for updateBalls
     vector<PowerUpDefinition> powerupDefinitions; 
-    vector<SpriteManager::Sprite> floatingPowerups;
+    vector<FloatingPowerUp> floatingPowerups;
     PowerUp activePowerup;
     size_t score;
 
-    float nextTrailEmit;
-    
-    void reflectBall(bool horizontal, float limit);
-    void explodeBrick(
-        const glm::vec4& color,
-        const glm::vec2& brickPos,
-        const glm::vec2& brickSize,
-        const glm::vec2& hitPoint,
-        float velocity
-    );
+    void splitBalls();
 
     // level specific data
-    vector<filesystem::path> levelList;
-    vector<filesystem::path>::const_iterator curLevel;
+    LevelPack levels;
+    size_t levelIndex;
     unique_ptr<Level> level;
+    JobSystem* jobs;
+    unique_ptr<Level> pendingLevel;         // levelIndex+1, built by levelPrefetch
+    JobSystem::Handle levelPrefetch;
+    vector<JobSystem::Handle> levelJobs;    // staging tasks reading pendingLevel
+    struct SnapshotHeader;
+    unique_ptr<Level> loadLevel(size_t index) const;
+    void prefetchLevel();
     void resetPlayer();
+    void stickBalls();
     void nextLevel();
-
-    AudioManager audioManager;
-    AudioManager::Audio brick,go,lost,paddle,solid,wall;
-
-    Font font;
 };
@@ -0,0 +1,458 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#include "gameview.h"
+#include "profiler.h"
+#include <glm/ext/matrix_clip_space.hpp>
+
+#include <SDL3/SDL_scancode.h>
+
+namespace
+{
+    //! every sprite texture of the game, loaded up front by name
+    const vector<pair<string, filesystem::path>> Textures =
+    {
+        { "background", "textures/background.png" },
+        { "frame_left", "textures/frame_left.png" },
+        { "frame_top", "textures/frame_top.png" },
+        { "frame_right", "textures/frame_right.png" },
+        { "paddle", "textures/paddle.png" },
+        { "ball", "textures/ball.png" },
+        { "speed", "textures/powerup_speed.png" },
+        { "sticky", "textures/powerup_sticky.png" },
+        { "passthrough", "textures/powerup_passthrough.png" },
+        { "increase", "textures/powerup_increase.png" },
+        { "confuse", "textures/powerup_confuse.png" },
+        { "chaos", "textures/powerup_chaos.png" },
+        { "multiball", "textures/powerup_multiball.png" },
+        { "block", "textures/block.png" },
+        { "solid", "textures/solid.png" }
+    };
+}
+
+//! @brief constructor
+GameView::GameView(Game& game, PostProcess& post, JobSystem& jobs, uint64_t seed) :
+    game(game),
+    post(post),
+    jobs(jobs),
+    effectsRng(seed, Game::RandomStreamEffects),
+    keys(),
+    showProfiler(false),
+    sceneSettings(),
+    sprites(3, Game::MaxBalls+1024+game.getMaxBrickCount(), 16),
+    blockTexture(0),
+    solidTexture(0),
+    ballTexture(0),
+    stagedLevel(numeric_limits<size_t>::max()),
+    trail((ceil(TrailEmitsPerSecond*TrailDuration)+1)*MaxTrailBalls, "textures/trail.png"),
+    brickParts(128,  "textures/fragment.png"),
+    nextTrailEmit(0.0f),
+    audioManager(seed),
+    font("textures/font.ttf")
+{
+    // falls back to the single texture files without an atlas
+    sprites.loadAtlas("textures/sprites.atlas", jobs);
+    sprites.preloadTextures(Textures, jobs);
+
+    // only the background and the frame go into the background layer, nothing there moves,
+    // so it is drawn once per screen size
+    sprites.setLayerCached(BackgroundLayer, true);
+    auto bg=sprites.getTexture("background");
+    staticImages.push_back(sprites.createSprite(BackgroundLayer, LogicalSize*0.5f, bg, BackgroundSize));
+    staticImages.push_back(sprites.createSprite(BackgroundLayer, {1,15}, sprites.getTexture("frame_left"), {2,30}));
+    staticImages.push_back(sprites.createSprite(BackgroundLayer, {15,1}, sprites.getTexture("frame_top"), {26,2}));
+    staticImages.push_back(sprites.createSprite(BackgroundLayer, {29,15}, sprites.getTexture("frame_right"), {2,30}));
+
+    blockTexture = sprites.getTexture("block");
+    solidTexture = sprites.getTexture("solid");
+
+    auto defaultPaddle = sprites.getTexture("paddle");
+    player=sprites.createSprite(
+        GameLayer,
+        game.getPlayer().pos,
+        defaultPaddle,
+        game.getPlayer().size
+    );
+
+    ballTexture=sprites.getTexture("ball");
+
+    powerupLooks.resize(Game::PowerUp::MAX);
+    powerupLooks[Game::PowerUp::None]={ defaultPaddle, NeutralPowerupColor };
+    powerupLooks[Game::PowerUp::Speed]={ sprites.getTexture("speed"), GoodPowerupColor };
+    powerupLooks[Game::PowerUp::Sticky]={ sprites.getTexture("sticky"), GoodPowerupColor };
+    powerupLooks[Game::PowerUp::PassThrough]={ sprites.getTexture("passthrough"), GoodPowerupColor };
+    powerupLooks[Game::PowerUp::Size]={ sprites.getTexture("increase"), GoodPowerupColor };
+    powerupLooks[Game::PowerUp::Confuse]={ sprites.getTexture("confuse"), BadPowerupColor };
+    powerupLooks[Game::PowerUp::Chaos]={ sprites.getTexture("chaos"), BadPowerupColor };
+    powerupLooks[Game::PowerUp::MultiBall]={ sprites.getTexture("multiball"), GoodPowerupColor };
+
+    brick=audioManager.loadWavWithVariations("sounds/brick0.wav","sounds/brick1.wav","sounds/brick2.wav");
+    go=audioManager.loadWav("sounds/go.wav");
+    lost=audioManager.loadWav("sounds/lost.wav");
+    paddle=audioManager.loadWavWithVariations("sounds/paddle0.wav","sounds/paddle1.wav");
+    solid=audioManager.loadWav("sounds/solid.wav");
+    wall=audioManager.loadWavWithVariations("sounds/wall0.wav","sounds/wall1.wav","sounds/wall2.wav");
+
+    // the game has loaded its first level before we were around
+    game.clearEvents();
+    levelLoaded(game.getLevel());
+}
+
+GameView::~GameView()
+{
+    game.finishLevelJobs();     // staging jobs write into this view
+}
+
+void GameView::updateScreenSize(const vk::Extent2D& extent, vk::SampleCountFlagBits samples)
+{
+    sprites.setSamples(samples);
+    trail.setSamples(samples);
+    brickParts.setSamples(samples);
+    font.setSamples(samples);
+    sceneSettings=format("SCENE {}X{} {}X MSAA", extent.width, extent.height, uint32_t(samples));
+
+    glm::vec2 screen={extent.width, extent.height};
+
+    float fieldAspect=LogicalSize.x/LogicalSize.y;
+    float screenAspect=screen.x/screen.y;
+
+    glm::vec2 viewport;
+    if (fieldAspect > screenAspect) // field is wider than screen
+    {
+        viewport.x = LogicalSize.x;
+        viewport.y = LogicalSize.x/screenAspect;
+    }
+    else
+    {
+        viewport.x = LogicalSize.y*screenAspect;
+        viewport.y = LogicalSize.y;
+    }
+    glm::vec2 offset=(viewport-LogicalSize)*0.5f;
+
+    auto ortho=glm::orthoRH_ZO(
+        -offset.x, viewport.x-offset.x,
+        -offset.y, viewport.y-offset.y,
+        0.0f, 1.0f);
+    sprites.setLayerTransform(BackgroundLayer, ortho);
+    sprites.setLayerTransform(GameLayer, ortho);
+    sprites.setLayerTransform(ForegroundLayer, ortho);
+    sprites.resizeCaches(extent);
+    trail.setTransformation(ortho);
+    brickParts.setTransformation(ortho);
+
+    font.resize(ortho, extent, FontSize);
+}
+
+void GameView::processInput(float dt)
+{
+    if (keys[SDL_SCANCODE_F3])
+    {
+        showProfiler=!showProfiler;
+        keys[SDL_SCANCODE_F3]=false;
+    }
+
+    game.setInput(getInput());
+    game.processInput(dt);
+
+    // one shot actions need a new key press to fire again
+    keys[SDL_SCANCODE_SPACE]=false;
+    keys[SDL_SCANCODE_L]=false;
+    for (int pu=Game::PowerUp::Speed; pu<Game::PowerUp::MAX; ++pu)
+    {
+        keys[SDL_SCANCODE_1+pu-1]=false;
+    }
+}
+
+Replay::Input GameView::getInput() const
+{
+    Replay::Input input=0;
+    if (keys[SDL_SCANCODE_LEFT] || keys[SDL_SCANCODE_A]) input|=Game::InputLeft;
+    if (keys[SDL_SCANCODE_RIGHT] || keys[SDL_SCANCODE_D]) input|=Game::InputRight;
+    if (keys[SDL_SCANCODE_SPACE]) input|=Game::InputLaunch;
+    if (keys[SDL_SCANCODE_L]) input|=Game::InputNextLevel;
+    for (int pu=Game::PowerUp::Speed; pu<Game::PowerUp::MAX; ++pu)
+    {
+        if (keys[SDL_SCANCODE_1+pu-1]) input|=Game::InputPowerup<<(pu-1);
+    }
+    return input;
+}
+
+void GameView::update(float dt)
+{
+    {
+        PROFILE_ZONE("Game::update");
+        game.update(dt);
+    }
+    handleEvents();
+
+    float decay=powf(1.0f-TrailDecayPerSecond,dt);
+    {
+        PROFILE_ZONE("GameView::updateParticles");
+        trail.update(dt, [dt,decay](auto& p) {
+            p.move(p.velocity*dt);
+            p.rotate(p.angularVelocity*dt);
+            p.velocity*=decay;
+            p.angularVelocity*=decay;
+            p.color.a*=decay;
+        }, jobs);
+
+        brickParts.update(dt, [dt,decay](auto& p) {
+            p.move(p.velocity*dt);
+            p.rotate(p.angularVelocity*dt);
+            p.velocity.y+=dt*Gravity;
+            p.color.a*=decay;
+        }, jobs);
+
+        emitTrail(dt);
+    }
+
+    syncSprites();
+}
+
+void GameView::emitTrail(float dt)
+{
+    auto& gameBalls=game.getBalls();
+    auto trailBalls=min(gameBalls.size(), MaxTrailBalls);
+
+    nextTrailEmit+=TrailEmitsPerSecond*dt;
+    for (; nextTrailEmit>1.0f; nextTrailEmit-=1.0f)
+    {
+        for (size_t i=0; i<trailBalls; ++i)
+        {
+            if (!gameBalls.stuck[i]) emitTrailParticle(gameBalls.pos(i));
+        }
+    }
+}
+
+void GameView::emitTrailParticle(const glm::vec2& bp)
+{
+    auto ofs=effectsRng.range(-TrailPosVar, TrailPosVar);
+    auto size=effectsRng.range(TrailSizeMin, TrailSizeMax);
+    auto rotation=effectsRng.range(0.0f, float(M_PI)*0.5f);
+    auto spin=effectsRng.range(-float(M_PI),float(M_PI))*3.0f;
+    trail.spawnParticleP(
+        TrailDuration,
+        TrailColor,
+        bp+ofs,
+        size,
+        rotation,
+        ofs*2.0f,
+        spin
+    );
+}
+
+void GameView::syncSprites()
+{
+    player->pos=game.getPlayer().pos;
+    player->size=game.getPlayer().size;
+
+    auto& gameBalls=game.getBalls();
+    if (balls.size()>gameBalls.size()) balls.resize(gameBalls.size());
+    for (size_t i=0; i<gameBalls.size(); ++i)
+    {
+        auto size=gameBalls.radius[i]*2.2f;
+        if (i==balls.size()) balls.push_back(sprites.createSprite(GameLayer, gameBalls.pos(i), ballTexture, { size, size }));
+        balls[i]->pos=gameBalls.pos(i);
+        balls[i]->size={ size, size };
+    }
+
+    auto& floating=game.getFloatingPowerups();
+    if (powerups.size()>floating.size()) powerups.resize(floating.size());
+    for (size_t i=0; i<floating.size(); ++i)
+    {
+        auto& look=powerupLooks[floating[i].type];
+        if (i==powerups.size())
+        {
+            powerups.push_back(sprites.createSprite(GameLayer, floating[i].pos, look.texture, Game::PowerupSize, look.color));
+        }
+        powerups[i]->pos=floating[i].pos;
+        powerups[i]->texture=look.texture;
+        powerups[i]->color=look.color;
+    }
+}
+
+void GameView::prepareDraw(const vk::CommandBuffer& commandBuffer)
+{
+    sprites.updateCaches(commandBuffer);
+}
+
+void GameView::draw(const vk::CommandBuffer& commandBuffer) const
+{
+    sprites.drawLayer(BackgroundLayer, commandBuffer);
+    trail.draw(commandBuffer);
+    sprites.drawLayer(GameLayer, commandBuffer);
+    brickParts.draw(commandBuffer);
+    sprites.drawLayer(ForegroundLayer, commandBuffer);
+
+    font.renderText(commandBuffer, ScoreLabelPos, "SCORE");
+
+    font.renderText(commandBuffer, ScorePos, format("{:05}", game.getScore()));
+
+    font.renderText(commandBuffer, BricksLabelPos, "BRICKS");
+
+    font.renderText(commandBuffer, BricksPos, format("{:03}", game.getLevel().getRemainingBricks()));
+
+    if (showProfiler)
+    {
+        auto pos=ProfilerPos;
+        font.renderText(commandBuffer, pos, sceneSettings);
+        pos.y+=ProfilerLineHeight;
+        for (auto&& line : profiler.getHudLines())
+        {
+            font.renderText(commandBuffer, pos, line);
+            pos.y+=ProfilerLineHeight;
+        }
+    }
+}
+
+void GameView::levelLoaded(const Level& level)
+{
+    PROFILE_ZONE("GameView::levelLoaded");
+
+    // switching levels waits for the staging job, but a second switch in the same tick
+    // comes after the job the first LevelLoaded submitted, which may still be running
+    game.finishStagingJobs();
+    if (stagedLevel!=game.getLevelIndex()) stageBricks(level, stagedCells, stagedBricks);
+    createBricks(level, stagedCells, stagedBricks);
+    stageNextLevel();
+}
+
+void GameView::stateRestored(const Level& level)
+{
+    // a staging job might still be writing the staged bricks
+    vector<size_t> cells;
+    vector<SpriteManager::SpriteData> data;
+    stageBricks(level, cells, data);
+    createBricks(level, cells, data);
+
+    // the staged bricks don't depend on the state, only on which level comes next
+    if (stagedLevel!=(game.getLevelIndex()+1)%game.getLevelCount()) stageNextLevel();
+}
+
+void GameView::stageNextLevel()
+{
+    stagedLevel=(game.getLevelIndex()+1)%game.getLevelCount();
+    game.stageNextLevel([this](const Level& next) { stageBricks(next, stagedCells, stagedBricks); });
+}
+
+void GameView::createBricks(const Level& level, const vector<size_t>& cells, const vector<SpriteManager::SpriteData>& data)
+{
+    bricks.clear();
+    bricks.resize(level.getBrickCount());
+    auto created=sprites.createSprites(GameLayer, data);
+    for (size_t i=0; i<created.size(); ++i) bricks[cells[i]]=std::move(created[i]);
+    syncSprites();
+}
+
+void GameView::stageBricks(const Level& level, vector<size_t>& cells, vector<SpriteManager::SpriteData>& data) const
+{
+    cells.clear();
+    data.clear();
+    for (size_t i=0; i<level.getBrickCount(); ++i)
+    {
+        if (!level.isBrick(i)) continue;
+
+        auto b=level.getBrick(i);
+        if (!b.isAlive()) continue;
+        cells.push_back(i);
+        data.emplace_back(b.pos, b.size, Level::getColor(b.type), b.hp>1 ? solidTexture : blockTexture);
+    }
+}
+
+void GameView::handleEvents()
+{
+    PROFILE_ZONE("GameView::handleEvents");
+    for (auto&& e : game.getEvents())
+    {
+        switch (e.type)
+        {
+        case Game::Event::LevelLoaded: levelLoaded(game.getLevel()); break;
+        case Game::Event::LevelCompleted: break;
+        case Game::Event::BallLaunched: go->play(); break;
+        case Game::Event::BallLost: lost->play(); break;
+        case Game::Event::WallHit: wall->play(); break;
+        case Game::Event::PaddleHit: paddle->play(); break;
+        case Game::Event::BrickHit: brickHit(e); break;
+        case Game::Event::PowerupChanged: powerupChanged(Game::PowerUp::Type(e.previousPowerup), Game::PowerUp::Type(e.powerup)); break;
+        case Game::Event::StateRestored: stateRestored(game.getLevel()); break;
+        }
+    }
+    game.clearEvents();
+}
+
+void GameView::brickHit(const Game::Event& event)
+{
+    auto index=event.brick;
+    auto data=game.getLevel().getBrick(index, event.cell);
+    auto hitPoint=event.point;
+    auto velocity=event.velocity;
+    if (data.isSolid())
+    {
+        solid->play();
+        post.shake(0.05);
+    }
+    else if (data.isAlive())
+    {
+        solid->play();
+        explodeBrick(Level::getColor(data.type), data.pos, data.size, hitPoint, velocity);
+        if (data.hp==1 && bricks[index]) bricks[index]->texture=blockTexture;
+    }
+    else
+    {
+        brick->play();
+        explodeBrick(Level::getColor(data.type), data.pos, data.size, hitPoint, velocity);
+        bricks[index]=nullptr; // destroy block
+    }
+}
+
+void GameView::powerupChanged(Game::PowerUp::Type previous, Game::PowerUp::Type current)
+{
+    auto timeLeft=game.getActivePowerup().timeLeft;
+    switch (previous)
+    {
+    case Game::PowerUp::Confuse: post.confuse(0.0f); break;
+    case Game::PowerUp::Chaos: post.chaos(0.0f); break;
+    default: break;
+    }
+
+    switch (current)
+    {
+    case Game::PowerUp::Confuse: post.confuse(timeLeft); break;
+    case Game::PowerUp::Chaos: post.chaos(timeLeft); break;
+    default:break;
+    }
+
+    auto&& look = powerupLooks[current];
+    player->texture = look.texture;
+    player->color = look.color;
+}
+
+void GameView::explodeBrick(
+    const glm::vec4& color,
+    const glm::vec2& brickPos,
+    const glm::vec2& brickSize,
+    const glm::vec2& hitPoint,
+    float velocity
+)
+{
+    for (float y=-0.25f; y<0.5f; y+=0.5f)
+    {
+        for (float x=-0.375f; x<0.5f; x+=0.25f)
+        {
+            auto center=brickPos+glm::vec2{x,y}*brickSize;
+            auto dir=glm::normalize(center-hitPoint);
+            auto rotation=effectsRng.range(0.0f, float(M_PI)*2.0f);
+            auto spin=effectsRng.range(-float(M_PI),float(M_PI))*5.0f;
+            brickParts.spawnParticleP(
+                1.0f,
+                color,
+                center,
+                glm::vec2{brickSize.x*0.25f, brickSize.y*0.5f},
+                rotation,
+                dir*velocity,
+                spin
+            );
+
+        }
+    }
+}
@@ -0,0 +1,142 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#pragma once
+
+#include "common.h"
+#include "game.h"
+#include "spritemanager.h"
+#include "audiomanager.h"
+#include "particlesystem.h"
+#include "postprocess.h"
+#include "font.h"
+#include "jobsystem.h"
+#include "random.h"
+
+//! @brief everything needed to see, hear and play a Game.
+//! Owns the sprites, particles, sounds and the font, turns key presses into
+//! game input and plays the game's events back as sound, particles and
+//! sprite changes after every update.
+class GameView
+{
+public:
+    static constexpr size_t KeyCount = 1024;
+
+    static constexpr size_t BackgroundLayer = 0;
+    static constexpr size_t GameLayer = 1;
+    static constexpr size_t ForegroundLayer = 2;
+
+    static constexpr glm::vec2 LogicalSize = { 40.0f, 30.0f };
+    static constexpr glm::vec2 BackgroundSize = { 48.0f, 38.0f };
+
+    static constexpr glm::vec4 NeutralPowerupColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+    static constexpr glm::vec4 GoodPowerupColor = { 0.5f, 0.5f, 1.0f, 1.0f };
+    static constexpr glm::vec4 BadPowerupColor = { 1.0f, 0.25f, 0.25f, 1.0f };
+
+    static constexpr float TrailDuration = .5f;
+    static constexpr float TrailDecayPerSecond = 0.99f;      
+    static constexpr float TrailEmitsPerSecond = 60.0f;
+    static constexpr glm::vec4 TrailColor = { 1.0f, 1.0f, 0.2f, 1.0f };
+    static constexpr glm::vec2 TrailSizeMin = { 0.2f, 0.2f };
+    static constexpr glm::vec2 TrailSizeMax = { 0.5f, 0.5f };
+    static constexpr glm::vec2 TrailPosVar = { 0.3f, 0.3f };
+    static constexpr float Gravity = 62.0f;
+    static constexpr size_t MaxTrailBalls = 8;      // only the first few balls leave a trail
+
+    static constexpr float FontSize = 1.5f;
+
+    static constexpr glm::vec2 ScoreLabelPos = { 31.0f, 4.0f };
+    static constexpr glm::vec2 ScorePos =      { 31.0f, 8.0f };
+    static constexpr glm::vec2 BricksLabelPos ={ 31.0f, 12.0f };
+    static constexpr glm::vec2 BricksPos =     { 31.0f, 16.0f };
+    static constexpr glm::vec2 ProfilerPos =   { 31.0f, 24.0f };
+    static constexpr float ProfilerLineHeight = 2.0f;
+
+public:
+    struct TrailData
+    {
+        glm::vec2 velocity;
+        glm::f32 angularVelocity;
+    };
+
+    struct PowerUpLook
+    {
+        SpriteManager::Texture texture;
+        glm::vec4 color;
+    };
+
+public:
+    GameView(Game& game, PostProcess& post, JobSystem& jobs, uint64_t seed);
+    ~GameView();
+
+    //! extent and samples of the render target the view draws into
+    void updateScreenSize(const vk::Extent2D& extent, vk::SampleCountFlagBits samples);
+    void processInput(float dt);
+    void update(float dt);
+    //! rendering that has to happen before the scene pass, i.e. the cached sprite layers
+    void prepareDraw(const vk::CommandBuffer& commandBuffer);
+    void draw(const vk::CommandBuffer& commandBuffer) const;
+
+    inline void setKey(size_t key, bool pressed)
+    {
+        if (key < KeyCount)
+            keys[key] = pressed;
+    }
+
+    //! the game input for the keys that are currently pressed
+    Replay::Input getInput() const;
+
+private:
+    Game& game;
+    PostProcess& post;
+    JobSystem& jobs;
+    Random effectsRng;
+
+    bool keys[KeyCount];
+    bool showProfiler;
+    string sceneSettings;       // first line of the profiler overlay
+
+    // draws all our sprites
+    SpriteManager sprites;
+    SpriteManager::Texture blockTexture, solidTexture;
+    vector<SpriteManager::Sprite> staticImages;
+    SpriteManager::Sprite player;
+    SpriteManager::Texture ballTexture;
+    vector<SpriteManager::Sprite> balls;
+    vector<SpriteManager::Sprite> bricks;      // one per level cell, null for empty cells
+    // brick sprites of the next level, prepared on a worker (see Game::stageNextLevel)
+    size_t stagedLevel;
+    vector<size_t> stagedCells;
+    vector<SpriteManager::SpriteData> stagedBricks;
+    vector<SpriteManager::Sprite> powerups;
+    vector<PowerUpLook> powerupLooks;          // indexed by powerup type
+    ParticleSystem<TrailData> trail,brickParts;
+
+    float nextTrailEmit;
+
+    void emitTrail(float dt);
+    void emitTrailParticle(const glm::vec2& pos);
+    void syncSprites();
+
+    // game events
+    void handleEvents();
+    void levelLoaded(const Level& level);
+    void brickHit(const Game::Event& event);
+    void powerupChanged(Game::PowerUp::Type previous, Game::PowerUp::Type current);
+    void stateRestored(const Level& level);
+    void stageBricks(const Level& level, vector<size_t>& cells, vector<SpriteManager::SpriteData>& data) const;
+    void createBricks(const Level& level, const vector<size_t>& cells, const vector<SpriteManager::SpriteData>& data);
+    void stageNextLevel();
+    void explodeBrick(
+        const glm::vec4& color,
+        const glm::vec2& brickPos,
+        const glm::vec2& brickSize,
+        const glm::vec2& hitPoint,
+        float velocity
+    );
+
+    AudioManager audioManager;
+    AudioManager::Audio brick,go,lost,paddle,solid,wall;
+
+    Font font;
+};
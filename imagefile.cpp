@@ -0,0 +1,223 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+
+#include "imagefile.h"
+#include "stb_image.h"
+#include <fstream>
+#include <cstring>
+
+namespace
+{
+    constexpr uint8_t Ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    struct Ktx2Header
+    {
+        uint8_t identifier[12];
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+    };
+
+    struct Ktx2Level
+    {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    static_assert(sizeof(Ktx2Header)==80 && sizeof(Ktx2Level)==24, "KTX2 structs must not have padding");
+
+    //! the basic data format descriptor every KTX2 file needs, see the Khronos Data Format specification
+    vector<uint32_t> createDataFormatDescriptor(vk::Format format)
+    {
+        // color models, channels and sample qualifiers from khr_df.h
+        constexpr uint32_t ModelRgbsda=1, ModelBc1a=128, ModelBc3=130, ModelBc7=134;
+        constexpr uint32_t PrimariesBt709=1, TransferSrgb=2;
+        constexpr uint32_t ChannelAlpha=15, SampleLinear=0x10;
+
+        struct Sample
+        {
+            uint32_t bitOffset;
+            uint32_t bitLength;
+            uint32_t channel;
+            uint32_t upper;
+        };
+        uint32_t model;
+        vector<Sample> samples;
+        auto block=getFormatBlock(format);
+        switch (format)
+        {
+        case vk::Format::eR8G8B8A8Srgb:
+            model=ModelRgbsda;
+            samples={ { 0, 8, 0, 255 }, { 8, 8, 1, 255 }, { 16, 8, 2, 255 }, { 24, 8, ChannelAlpha|SampleLinear, 255 } };
+            break;
+        case vk::Format::eBc1RgbSrgbBlock:
+            model=ModelBc1a;
+            samples={ { 0, 64, 0, 0xFFFFFFFF } };
+            break;
+        case vk::Format::eBc3SrgbBlock:
+            model=ModelBc3;
+            samples={ { 0, 64, ChannelAlpha|SampleLinear, 0xFFFFFFFF }, { 64, 64, 0, 0xFFFFFFFF } };
+            break;
+        default:
+            model=ModelBc7;
+            samples={ { 0, 128, 0, 0xFFFFFFFF } };
+            break;
+        }
+
+        auto blockSize=uint32_t(24+16*samples.size());
+        vector<uint32_t> result={
+            4+blockSize,                                    // total size
+            0,                                              // vendor Khronos, basic descriptor
+            2 | (blockSize<<16),                            // version 2
+            model | (PrimariesBt709<<8) | (TransferSrgb<<16),
+            (block.size-1) | ((block.size-1)<<8),           // texel block dimensions
+            block.bytes,                                    // bytes of plane 0
+            0
+        };
+        for (auto&& s : samples)
+        {
+            result.push_back(s.bitOffset | ((s.bitLength-1)<<16) | (s.channel<<24));
+            result.push_back(0);                            // sample position
+            result.push_back(0);                            // lower
+            result.push_back(s.upper);
+        }
+        return result;
+    }
+
+    ImageData readKtx2(const filesystem::path& file)
+    {
+        auto fail=[&file](const string& what) { return runtime_error(what+" '"+file.string()+"'"); };
+
+        // the whole file goes to the staging buffer, the levels are uploaded right from it
+        auto in=ifstream(file, ios::binary);
+        if (!in) throw fail("Failed to open texture");
+        ImageData image;
+        image.pixels.resize(filesystem::file_size(file));
+        if (!in.read(reinterpret_cast<char*>(image.pixels.data()), image.pixels.size())) throw fail("Failed to read texture");
+
+        Ktx2Header header;
+        if (image.pixels.size()<sizeof(header)) throw fail("Truncated KTX2 file");
+        memcpy(&header, image.pixels.data(), sizeof(header));
+        if (memcmp(header.identifier, Ktx2Identifier, sizeof(Ktx2Identifier))!=0) throw fail("Not a KTX2 file");
+        if (header.pixelDepth!=0 || header.layerCount>1 || header.faceCount!=1) throw fail("Only plain 2D textures are supported in");
+        if (header.supercompressionScheme!=0) throw fail("Supercompressed textures are not supported in");
+        if (header.levelCount==0) throw fail("Missing mip levels in");
+
+        image.format=vk::Format(header.vkFormat);
+        image.extent={ header.pixelWidth, header.pixelHeight };
+
+        if (header.levelCount>(image.pixels.size()-sizeof(header))/sizeof(Ktx2Level)) throw fail("Truncated KTX2 file");
+        for (uint32_t i=0; i<header.levelCount; ++i)
+        {
+            Ktx2Level level;
+            memcpy(&level, image.pixels.data()+sizeof(header)+i*sizeof(Ktx2Level), sizeof(level));
+            if (level.byteOffset>image.pixels.size() || level.byteLength>image.pixels.size()-level.byteOffset ||
+                level.byteLength!=getLevelSize(image.format, image.extent, i))
+            {
+                throw fail("Corrupt mip level "+to_string(i)+" in");
+            }
+            image.levels.emplace_back(size_t(level.byteOffset), size_t(level.byteLength));
+        }
+        return image;
+    }
+
+    ImageData decodeImage(const filesystem::path& file)
+    {
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load(file.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+        if (!pixels) {
+            throw std::runtime_error("failed to load texture image '"+file.string()+"'!");
+        }
+
+        auto byteSize = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+        auto data = ImageData
+        {
+            .extent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) },
+            .levels = { { 0, byteSize } },
+            .pixels = vector<byte>(reinterpret_cast<const byte*>(pixels), reinterpret_cast<const byte*>(pixels)+byteSize)
+        };
+        stbi_image_free(pixels);
+        return data;
+    }
+}
+
+[[nodiscard]] FormatBlock getFormatBlock(vk::Format format)
+{
+    switch (format)
+    {
+    case vk::Format::eR8G8B8A8Srgb: return { 1, 4 };
+    case vk::Format::eBc1RgbSrgbBlock: return { 4, 8 };
+    case vk::Format::eBc3SrgbBlock: return { 4, 16 };
+    case vk::Format::eBc7SrgbBlock: return { 4, 16 };
+    default: throw runtime_error("Unsupported texture format "+vk::to_string(format));
+    }
+}
+
+[[nodiscard]] size_t getLevelSize(vk::Format format, vk::Extent2D extent, uint32_t level)
+{
+    auto block=getFormatBlock(format);
+    auto width=max(extent.width>>level, 1u);
+    auto height=max(extent.height>>level, 1u);
+    return size_t((width+block.size-1)/block.size)*((height+block.size-1)/block.size)*block.bytes;
+}
+
+[[nodiscard]] ImageData readImageFile(const filesystem::path& file)
+{
+    if (file.extension()==".ktx2") return readKtx2(file);
+    return decodeImage(file);
+}
+
+void writeKtx2(const filesystem::path& file, const ImageData& image)
+{
+    auto block=getFormatBlock(image.format);
+    auto dfd=createDataFormatDescriptor(image.format);
+
+    Ktx2Header header={};
+    memcpy(header.identifier, Ktx2Identifier, sizeof(Ktx2Identifier));
+    header.vkFormat=uint32_t(image.format);
+    header.typeSize=1;     // 8 bit channels or compressed blocks
+    header.pixelWidth=image.extent.width;
+    header.pixelHeight=image.extent.height;
+    header.faceCount=1;
+    header.levelCount=uint32_t(image.levels.size());
+    header.dfdByteOffset=uint32_t(sizeof(header)+image.levels.size()*sizeof(Ktx2Level));
+    header.dfdByteLength=uint32_t(dfd.size()*sizeof(uint32_t));
+
+    // every level starts at a multiple of the block size, which for our formats is also a multiple of 4
+    auto alignment=max<uint64_t>(block.bytes, 4);
+    vector<Ktx2Level> levels(image.levels.size());
+    uint64_t offset=header.dfdByteOffset+header.dfdByteLength;
+    for (size_t i=image.levels.size(); i-->0;)
+    {
+        offset=(offset+alignment-1)/alignment*alignment;
+        levels[i]={ offset, image.levels[i].size, image.levels[i].size };
+        offset+=image.levels[i].size;
+    }
+
+    auto out=ofstream(file, ios::binary);
+    if (!out) throw runtime_error("Failed to open texture '"+file.string()+"'");
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(levels.data()), levels.size()*sizeof(Ktx2Level));
+    out.write(reinterpret_cast<const char*>(dfd.data()), dfd.size()*sizeof(uint32_t));
+    const char padding[16]={};
+    for (size_t i=image.levels.size(); i-->0;)
+    {
+        out.write(padding, levels[i].byteOffset-uint64_t(out.tellp()));
+        out.write(reinterpret_cast<const char*>(image.pixels.data()+image.levels[i].offset), image.levels[i].size);
+    }
+    if (!out) throw runtime_error("Failed to write texture '"+file.string()+"'");
+}
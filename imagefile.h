@@ -0,0 +1,44 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#pragma once
+
+#include "common.h"
+
+//! pixels of an image file ready for upload, either RGBA8 or block compressed
+//! straight from a KTX2 file. Mip level 0 is the full size image.
+struct ImageData
+{
+    struct Level
+    {
+        size_t offset;  // into pixels
+        size_t size;
+    };
+
+    vk::Extent2D extent;
+    vk::Format format = vk::Format::eR8G8B8A8Srgb;
+    vector<Level> levels;
+    vector<byte> pixels;
+};
+
+//! size of the pixel blocks of the formats we read and write, 1x1 for uncompressed formats
+struct FormatBlock
+{
+    uint32_t size;      // width and height in pixels
+    uint32_t bytes;
+};
+
+//! throws for formats the image files can't hold
+[[nodiscard]] FormatBlock getFormatBlock(vk::Format format);
+
+//! bytes of one mip level of an image
+[[nodiscard]] size_t getLevelSize(vk::Format format, vk::Extent2D extent, uint32_t level);
+
+//! read exactly this file: KTX2 files as they are (see writeKtx2), everything
+//! else is decoded into RGBA8 with a single level. Safe to call from worker threads.
+[[nodiscard]] ImageData readImageFile(const filesystem::path& file);
+
+//! @brief write a KTX2 file without supercompression, the levels are stored
+//! smallest first as the format wants it.
+//! see https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+void writeKtx2(const filesystem::path& file, const ImageData& image);
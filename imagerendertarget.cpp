@@ -4,14 +4,34 @@
 
 #include "imagerendertarget.h"
 #include "vulkan.h"
+#include <cmath>
 
-void ImageRenderTarget::reset(const ImageDescription& description, size_t imageCount)
+namespace
 {
+    vk::Extent2D scaleExtent(const vk::Extent2D& extent, float scale)
+    {
+        return {
+            max(uint32_t(lround(extent.width*scale)), 1u),
+            max(uint32_t(lround(extent.height*scale)), 1u)
+        };
+    }
+}
+
+void ImageRenderTarget::reset(const ImageDescription& description, size_t imageCount, vk::SampleCountFlagBits samples, float renderScale)
+{
+    baseExtent=description.extent;
+    auto scaled=description;
+    scaled.extent=scaleExtent(description.extent, clamp(renderScale, MinRenderScale, MaxRenderScale));
+
     createImages(
-        description,
-        vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled,
-        vk::SampleCountFlagBits::e4,
+        scaled,
+        vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc,
+        samples,
         imageCount
     );
 }
 
+void ImageRenderTarget::setRenderScale(float renderScale)
+{
+    setRenderExtent(scaleExtent(baseExtent, clamp(renderScale, MinRenderScale, MaxRenderScale)));
+}
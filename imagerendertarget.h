@@ -8,10 +8,23 @@
 class ImageRenderTarget : public MultisampleRenderTarget
 {
 public:
+    static constexpr float MinRenderScale = 0.5f;
+    static constexpr float MaxRenderScale = 2.0f;
+
     using MultisampleRenderTarget::RenderTarget;
     
-    void reset(const ImageDescription& description, size_t imageCount);
+    //! @brief the images get renderScale times the extent of description,
+    //! clamped to MinRenderScale..MaxRenderScale. Whoever draws them to the
+    //! screen scales them back, see PostProcess.
+    void reset(const ImageDescription& description, size_t imageCount, vk::SampleCountFlagBits samples=vk::SampleCountFlagBits::e4, float renderScale=1.0f);
+
+    //! @brief renders to the top left part of the images that matches renderScale,
+    //! which can't go above the scale given to reset. Nothing is reallocated, so
+    //! this can change every frame (see ResolutionController).
+    void setRenderScale(float renderScale);
+
     using MultisampleRenderTarget::cycle;
 
-    inline DeviceImage& getCurrent() const { return *current; }
-};
\ No newline at end of file
+private:
+    vk::Extent2D baseExtent;    // extent before scaling
+};
@@ -0,0 +1,235 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+
+#include "jobsystem.h"
+
+namespace
+{
+    // identifies the job system and queue owned by the current worker thread
+    thread_local const JobSystem* currentSystem = nullptr;
+    thread_local size_t currentWorker = 0;
+}
+
+size_t JobSystem::defaultWorkerCount()
+{
+    // the main thread helps out while waiting, so leave one core for it
+    auto cores=thread::hardware_concurrency();
+    return cores>1 ? cores-1 : 0;
+}
+
+JobSystem::JobSystem(size_t workerCount) :
+    workers(),
+    queues(),
+    queuedJobs(0),
+    stopping(false)
+{
+    for (size_t i=0; i<=workerCount; ++i) queues.push_back(make_unique<Queue>());
+
+    workers.reserve(workerCount);
+    for (size_t i=0; i<workerCount; ++i)
+    {
+        workers.emplace_back(&JobSystem::workerMain, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        lock_guard guard(sleepLock);
+        stopping=true;
+    }
+    wakeup.notify_all();
+    for (auto&& w : workers) w.join();
+}
+
+JobSystem::Handle JobSystem::submit(function<void()> task, span<const Handle> dependencies)
+{
+    auto job=make_shared<Job>();
+    job->task=std::move(task);
+
+    for (auto&& dep : dependencies)
+    {
+        if (!dep) continue;
+        lock_guard guard(dep->lock);
+        if (!dep->isFinished())
+        {
+            job->pendingDependencies.fetch_add(1, memory_order_relaxed);
+            dep->continuations.push_back(job);
+        }
+    }
+
+    // release the count held during setup, dependencies may all be done already
+    if (job->pendingDependencies.fetch_sub(1, memory_order_acq_rel)==1) schedule(job);
+    return job;
+}
+
+void JobSystem::wait(const Handle& job)
+{
+    if (!job) return;
+
+    auto queue=currentQueue();
+    while (!job->isFinished())
+    {
+        if (auto next=findJob(queue)) execute(next);
+        else this_thread::yield();
+    }
+
+    if (job->error) rethrow_exception(job->error);
+}
+
+void JobSystem::wait(span<const Handle> jobs)
+{
+    // all jobs have to finish before anything is rethrown, they may use the caller's data
+    exception_ptr error;
+    for (auto&& job : jobs)
+    {
+        try
+        {
+            wait(job);
+        }
+        catch (...)
+        {
+            if (!error) error=current_exception();
+        }
+    }
+    if (error) rethrow_exception(error);
+}
+
+void JobSystem::parallelFor(size_t count, size_t grainSize, const function<void(size_t begin, size_t end)>& body)
+{
+    if (count==0) return;
+    grainSize=max<size_t>(grainSize, 1);
+
+    // a few chunks per thread give the stealing some room to balance uneven work
+    size_t chunks=min((count+grainSize-1)/grainSize, (workers.size()+1)*4);
+    if (chunks<=1)
+    {
+        body(0, count);
+        return;
+    }
+
+    size_t chunkSize=(count+chunks-1)/chunks;
+    vector<Handle> handles;
+    handles.reserve(chunks);
+    for (size_t begin=chunkSize; begin<count; begin+=chunkSize)
+    {
+        handles.push_back(submit([&body, begin, end=min(begin+chunkSize, count)]() { body(begin, end); }));
+    }
+
+    // the calling thread takes the first chunk itself. The other chunks use body,
+    // so they have to be done before its exception leaves this function
+    exception_ptr error;
+    try
+    {
+        body(0, chunkSize);
+    }
+    catch (...)
+    {
+        error=current_exception();
+    }
+    try
+    {
+        wait(handles);
+    }
+    catch (...)
+    {
+        if (!error) error=current_exception();
+    }
+    if (error) rethrow_exception(error);
+}
+
+void JobSystem::workerMain(size_t index)
+{
+    currentSystem=this;
+    currentWorker=index;
+
+    while (true)
+    {
+        if (auto job=findJob(index))
+        {
+            execute(job);
+            continue;
+        }
+
+        unique_lock guard(sleepLock);
+        wakeup.wait(guard, [this]() { return stopping || queuedJobs.load()>0; });
+        if (stopping) return;
+    }
+}
+
+size_t JobSystem::currentQueue() const noexcept
+{
+    return currentSystem==this ? currentWorker : workers.size();
+}
+
+void JobSystem::schedule(Handle job)
+{
+    auto& queue=*queues[currentQueue()];
+    {
+        lock_guard guard(queue.lock);
+        queue.jobs.push_back(std::move(job));
+    }
+    queuedJobs.fetch_add(1);
+
+    // taking the lock makes sure a worker about to sleep sees the new job
+    { lock_guard guard(sleepLock); }
+    wakeup.notify_one();
+}
+
+JobSystem::Handle JobSystem::findJob(size_t queue)
+{
+    if (queuedJobs.load()==0) return nullptr;
+
+    // own queue first (LIFO for cache locality), then steal from the others (FIFO)
+    {
+        auto& own=*queues[queue];
+        lock_guard guard(own.lock);
+        if (!own.jobs.empty())
+        {
+            auto job=std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queuedJobs.fetch_sub(1);
+            return job;
+        }
+    }
+
+    for (size_t i=1; i<queues.size(); ++i)
+    {
+        auto& victim=*queues[(queue+i)%queues.size()];
+        lock_guard guard(victim.lock);
+        if (!victim.jobs.empty())
+        {
+            auto job=std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queuedJobs.fetch_sub(1);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::execute(const Handle& job)
+{
+    try
+    {
+        job->task();
+    }
+    catch (...)
+    {
+        job->error=current_exception();
+    }
+    job->task=nullptr;
+
+    vector<Handle> continuations;
+    {
+        lock_guard guard(job->lock);
+        job->finished.store(true, memory_order_release);
+        swap(continuations, job->continuations);
+    }
+
+    for (auto&& next : continuations)
+    {
+        if (next->pendingDependencies.fetch_sub(1, memory_order_acq_rel)==1) schedule(std::move(next));
+    }
+}
@@ -0,0 +1,97 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#pragma once
+
+#include "common.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <functional>
+#include <span>
+
+//! @brief small work-stealing thread pool shared by all subsystems.
+//! Every worker owns a deque of jobs. It pops work from the back of its own
+//! deque and steals from the front of the other deques when it runs dry.
+//! Threads that wait for a job help executing jobs instead of blocking, so
+//! a JobSystem without any workers simply runs everything inline.
+class JobSystem
+{
+public:
+    class Job
+    {
+    public:
+        inline bool isFinished() const noexcept { return finished.load(memory_order_acquire); }
+
+    private:
+        function<void()> task;
+        atomic<size_t> pendingDependencies = 1;   // the extra count is released by submit
+        atomic<bool> finished = false;
+        mutex lock;
+        vector<shared_ptr<Job>> continuations;
+        exception_ptr error;
+
+        friend class JobSystem;
+    };
+
+    using Handle = shared_ptr<Job>;
+
+    static size_t defaultWorkerCount();
+
+public:
+    JobSystem(size_t workerCount=defaultWorkerCount());
+    ~JobSystem();
+
+    JobSystem(const JobSystem& rhs) = delete;
+    JobSystem& operator=(const JobSystem& rhs) = delete;
+
+    //! schedule a task that starts once all dependencies have finished
+    Handle submit(function<void()> task, span<const Handle> dependencies={});
+    inline Handle submit(function<void()> task, initializer_list<Handle> dependencies)
+    {
+        return submit(std::move(task), span<const Handle>(dependencies.begin(), dependencies.size()));
+    }
+
+    //! wait for a job to finish, executing other jobs while waiting.
+    //! rethrows any exception thrown by the job.
+    void wait(const Handle& job);
+    //! waits for all jobs, then rethrows the first exception
+    void wait(span<const Handle> jobs);
+
+    //! fork/join: run all tasks in parallel and return when all have finished
+    template<typename... F>
+    void fork(F&&... tasks)
+    {
+        array<Handle, sizeof...(F)> handles = { submit(std::forward<F>(tasks))... };
+        wait(handles);
+    }
+
+    //! split [0,count) into chunks of at least grainSize elements and call
+    //! body(begin, end) for each chunk in parallel. Small ranges run inline.
+    void parallelFor(size_t count, size_t grainSize, const function<void(size_t begin, size_t end)>& body);
+
+    inline size_t getWorkerCount() const noexcept { return workers.size(); }
+
+private:
+    struct Queue
+    {
+        mutex lock;
+        deque<Handle> jobs;
+    };
+
+    vector<thread> workers;
+    vector<unique_ptr<Queue>> queues;   // one per worker plus one shared queue for external threads
+
+    mutex sleepLock;
+    condition_variable wakeup;
+    atomic<size_t> queuedJobs;
+    atomic<bool> stopping;
+
+    void workerMain(size_t index);
+    size_t currentQueue() const noexcept;
+    void schedule(Handle job);
+    Handle findJob(size_t queue);
+    void execute(const Handle& job);
+};
@@ -3,10 +3,8 @@
 //! please see LICENSE file in root folder for licensing terms.
 
 #include "level.h"
-#include <fstream>
-#include <sstream>
 
-static glm::vec4 Colors[]=
+static glm::vec4 Colors[Level::BrickTypeCount]=
 {
     { 0.0f, 0.0f, 0.0f, 0.0f },     // empty
     { 0.95f, 0.95f, 0.95f, 1.0f },  // 1 - white - 50 pts
@@ -21,88 +19,81 @@ static glm::vec4 Colors[]=
     { 0.74f, 0.69f, 0.0f, 1.0f}     // X - solid
 };
 
-Level::Level(const filesystem::path& path, glm::vec2 topLeft, glm::vec2 blockSize, SpriteManager& sprites, size_t layer)
+Level::Level(const Layout& layout, glm::vec2 topLeft, glm::vec2 blockSize) :
+    destructibleBricks(layout.destructibleBricks),
+    remainingBricks(layout.destructibleBricks),
+    topLeft(topLeft),
+    blockSize(blockSize),
+    columns(layout.columns),
+    rows(layout.rows),
+    cells(layout.cells.begin(), layout.cells.end())
 {
-    block = sprites.getOrCreateTexture("block", "textures/block.png");
-    solid = sprites.getOrCreateTexture("solid", "textures/solid.png");
+    if (cells.size()!=columns*rows) throw runtime_error("Level cells don't match its size");
+}
+
+Level::Brick Level::getBrick(size_t index, Cell cell) const noexcept
+{
+    auto hp=cellHp(cell);
+    auto type=cellType(cell);
+    auto column=index%columns;
+    auto row=index/columns;
+    return {
+        topLeft+glm::vec2{ float(column)+0.5f, float(row)+0.5f }*blockSize,
+        blockSize,
+        size_t(40+type*10),
+        hp==SolidHp ? Indestructible : size_t(hp),
+        type
+    };
+}
 
-    // load from file
-    string line;
-    auto file=ifstream(path);
-    float y=topLeft.y + blockSize.y*0.5f;
-    while (getline(file, line)) // read each line from level file
+optional<Level::Hit> Level::getBallCollision(const glm::vec2& pos, const glm::vec2& movement, float radius) const
+{
+    // only look at the cells touched by the swept ball
+    auto from=glm::floor((glm::min(pos, pos+movement)-radius-topLeft)/blockSize);
+    auto to=glm::floor((glm::max(pos, pos+movement)+radius-topLeft)/blockSize);
+    auto firstColumn=static_cast<ptrdiff_t>(max(from.x, 0.0f));
+    auto lastColumn=min(static_cast<ptrdiff_t>(min(to.x, float(columns))), ptrdiff_t(columns)-1);
+    auto firstRow=static_cast<ptrdiff_t>(max(from.y, 0.0f));
+    auto lastRow=min(static_cast<ptrdiff_t>(min(to.y, float(rows))), ptrdiff_t(rows)-1);
+
+    optional<Hit> first;
+    for (auto row=firstRow; row<=lastRow; ++row)
     {
-        float x=topLeft.x - blockSize.x*0.5f;
-        for (char c : line)
+        for (auto column=firstColumn; column<=lastColumn; ++column)
         {
-            x+=blockSize.x;
-            if (c==32) continue;
+            auto index=size_t(row)*columns+size_t(column);
+            if (cellHp(cells[index])==0) continue;     // empty or destroyed
 
-            auto color = c-48;
-            size_t hp = 1;
-            if (c=='S')
-            {
-                color=9;
-                hp=2;
-            }
-            else if (c=='X')
+            auto center=topLeft+glm::vec2{ float(column)+0.5f, float(row)+0.5f }*blockSize;
+            auto contact=sweepCircleBox(pos, movement, radius, center, blockSize*0.5f);
+            if (contact && (!first || contact->time<first->contact.time))
             {
-                color=10;
-                hp=size_t(-1);
+                first=Hit{ index, *contact };
             }
-
-            bricks.emplace_back(
-                sprites.createSprite(
-                    layer, 
-                    {x,y},
-                    hp>1 ? solid:block,
-                    blockSize,
-                    Colors[color]
-                ),
-                40+color*10,
-                hp
-            );
-            
         }
-        y+=blockSize.y;
     }
+    return first;
 }
 
-tuple<SpriteManager::Sprite, glm::vec2, size_t, size_t> Level::getBallCollision(const glm::vec2& pos, float radius)
+void Level::hitBrick(size_t index)
 {
-    for (auto&& b : bricks)
+    auto& cell=cells[index];
+    auto hp=cellHp(cell);
+    if (hp>0 && hp!=SolidHp)
     {
-        if (b.sprite)
-        {
-            glm::vec2 halfBlockSize=b.sprite->size*0.5f;
-            // find closest point on sprite
-            glm::vec2 closest=pos-b.sprite->pos;    // vector to ball relative to brick
-            closest = glm::clamp(closest, -halfBlockSize, halfBlockSize);   // clamped to brick size
-            closest += b.sprite->pos; // transform into world coordinates
-            if (glm::length(closest-pos) < radius) // hit
-            {
-                auto result=b.sprite;
-                bool solid=(b.hp == size_t(-1));
-                if (!solid)
-                {
-                    b.hp--;
-                    if (b.hp==0)
-                    {
-                        b.sprite=nullptr; // destroy block
-                    }
-                    else if (b.hp==1)
-                    {
-                        b.sprite->texture=block;
-                    }
-                }
-                return tie(result, closest, b.hp, b.score);
-            }
-        }
+        cell=makeCell(cellType(cell), hp-1);
+        if (hp==1) --remainingBricks;
     }
-    return make_tuple(SpriteManager::Sprite{}, glm::vec2{}, false, 0);
 }
 
-bool Level::isComplete()
+void Level::restore(span<const Cell> saved)
+{
+    if (saved.size()!=cells.size()) throw runtime_error("Saved cells don't match the level");
+    ranges::copy(saved, cells.begin());
+    remainingBricks=countDestructible(cells);
+}
+
+const glm::vec4& Level::getColor(BrickType type) noexcept
 {
-    return ranges::all_of(bricks, [](auto&&b) { return (b.hp==size_t(-1)) || b.sprite==nullptr; });
+    return Colors[type<BrickTypeCount ? type : Empty];
 }
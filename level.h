@@ -4,25 +4,106 @@
 #pragma once
 
 #include "common.h"
-#include "spritemanager.h"
+#include "collision.h"
+#include <glm/glm.hpp>
+#include <span>
 
+//! @brief the bricks of one level. Pure game state, how the bricks look is
+//! up to whoever draws them. The level is a grid of blockSize cells holding
+//! one packed byte each, in the same layout as the compiled level pack, so
+//! loading a level is a single copy. Brick indices are cell indices.
 class Level
 {
 public:
-    Level(const filesystem::path& file, glm::vec2 topLeft, glm::vec2 blockSize, SpriteManager& sprites, size_t layer);
+    static constexpr size_t Indestructible = size_t(-1);
 
-    bool isComplete();
+    //! type in the low nibble, hit points in the high nibble
+    using Cell = uint8_t;
+    static constexpr uint8_t SolidHp = 15;  // hit points of indestructible bricks
+
+    enum BrickType : uint8_t
+    {
+        Empty,
+        // 1-8 are the colored bricks
+        Silver = 9,
+        Solid = 10,
+
+        BrickTypeCount
+    };
 
-    tuple<SpriteManager::Sprite,glm::vec2,size_t,size_t> getBallCollision(const glm::vec2& pos, float radius);
-    
-private:
     struct Brick
     {
-        SpriteManager::Sprite sprite;
+        glm::vec2 pos;
+        glm::vec2 size;
         size_t score;
-        size_t hp;
+        size_t hp;      // 0 once destroyed, Indestructible for solid bricks
+        BrickType type;
+
+        inline bool isAlive() const noexcept { return hp>0; }
+        inline bool isSolid() const noexcept { return hp==Indestructible; }
+    };
+
+    struct Hit
+    {
+        size_t brick;       // cell index
+        Contact contact;
+    };
+
+    //! the cells of a level as stored in a level pack
+    struct Layout
+    {
+        uint32_t columns;
+        uint32_t rows;
+        size_t destructibleBricks;
+        span<const Cell> cells;     // columns*rows, row by row
     };
 
-    SpriteManager::Texture block, solid;
-    vector<Brick> bricks;
-};
\ No newline at end of file
+    static constexpr Cell makeCell(BrickType type, uint8_t hp) noexcept { return Cell(type | (hp<<4)); }
+    static constexpr BrickType cellType(Cell cell) noexcept { return BrickType(cell & 0x0f); }
+    static constexpr uint8_t cellHp(Cell cell) noexcept { return cell>>4; }
+    //! bricks in cells that can still be destroyed
+    static inline size_t countDestructible(span<const Cell> cells) noexcept
+    {
+        return size_t(ranges::count_if(cells, [](Cell c) { return cellHp(c)>0 && cellHp(c)!=SolidHp; }));
+    }
+
+public:
+    Level(const Layout& layout, glm::vec2 topLeft, glm::vec2 blockSize);
+
+    //! all destructible bricks are gone
+    inline bool isComplete() const noexcept { return remainingBricks==0; }
+    inline size_t getRemainingBricks() const noexcept { return remainingBricks; }
+    inline size_t getDestructibleBricks() const noexcept { return destructibleBricks; }
+
+    //! find the first brick the ball touches while moving by movement
+    optional<Hit> getBallCollision(const glm::vec2& pos, const glm::vec2& movement, float radius) const;
+    //! take one hit point off a brick (solid bricks don't care)
+    void hitBrick(size_t brick);
+
+    inline span<const Cell> getCells() const noexcept { return cells; }
+    //! put back cells saved with getCells, the level size must not change.
+    //! The remaining bricks are counted from the cells.
+    void restore(span<const Cell> saved);
+
+    //! number of cells, empty cells have type Empty
+    inline size_t getBrickCount() const noexcept { return cells.size(); }
+    inline bool isBrick(size_t index) const noexcept { return cellType(cells[index])!=Empty; }
+    inline Brick getBrick(size_t index) const noexcept { return getBrick(index, cells[index]); }
+    //! the brick at index as it was when its cell looked like cell
+    Brick getBrick(size_t index, Cell cell) const noexcept;
+    inline size_t getColumns() const noexcept { return columns; }
+    inline size_t getRows() const noexcept { return rows; }
+    //! top left and bottom right corner of the brick grid
+    inline pair<glm::vec2, glm::vec2> getGridArea() const noexcept { return { topLeft, topLeft+glm::vec2{ columns, rows }*blockSize }; }
+
+    static const glm::vec4& getColor(BrickType type) noexcept;
+
+private:
+    size_t destructibleBricks;
+    size_t remainingBricks;     // counted down by hitBrick
+    glm::vec2 topLeft;
+    glm::vec2 blockSize;
+    size_t columns;
+    size_t rows;
+    vector<Cell> cells;         // row by row
+};
@@ -0,0 +1,60 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+
+#include "common.h"
+#include "levelpack.h"
+
+//! compiles text levels and generated stress test levels into a level pack,
+//! levels are stored in the order given. The generator settings apply to all
+//! following --generate arguments, the seed goes up by one per generated level.
+int main(int argc, char* argv[])
+try {
+    const auto usage="Usage: levelc output.pack [--density 0..1] [--solid 0..1] [--silver 0..1] [--seed N] "
+        "[--generate COLUMNSxROWS] [level.txt] ..."s;
+    if (argc<3) throw runtime_error(usage);
+
+    // the fractions are checked here so a mistake is reported by the argument's name
+    auto readFraction=[](string_view name, const char* text) {
+        float value=-1.0f;
+        try { value=stof(text); } catch (logic_error&) {}
+        if (!(value>=0.0f && value<=1.0f)) throw runtime_error(string(name)+" must be between 0 and 1, not '"+text+"'");
+        return value;
+    };
+
+    vector<LevelPack::Source> levels;
+    LevelPack::GeneratorSettings settings;
+    for (int i=2; i<argc; ++i)
+    {
+        auto arg=string_view(argv[i]);
+        if (arg=="--density" && i+1<argc) settings.density=readFraction(arg, argv[++i]);
+        else if (arg=="--solid" && i+1<argc) settings.solid=readFraction(arg, argv[++i]);
+        else if (arg=="--silver" && i+1<argc) settings.silver=readFraction(arg, argv[++i]);
+        else if (arg=="--seed" && i+1<argc) settings.seed=stoull(argv[++i]);
+        else if (arg=="--generate" && i+1<argc)
+        {
+            auto size=string(argv[++i]);
+            auto x=size.find('x');
+            if (x==string::npos) throw runtime_error("level size must look like 100x50, not '"+size+"'");
+            settings.columns=stoul(size.substr(0, x));
+            settings.rows=stoul(size.substr(x+1));
+            levels.push_back(LevelPack::generate(settings));
+            ++settings.seed;
+        }
+        else if (arg.starts_with("--")) throw runtime_error("unknown argument '"s+argv[i]+"'. "+usage);
+        else levels.push_back(LevelPack::parseText(argv[i]));
+    }
+    if (levels.empty()) throw runtime_error("no levels given. "+usage);
+    LevelPack::write(argv[1], levels);
+    return 0;
+}
+catch (runtime_error& e)
+{
+    cerr << "runtime error: " << e.what() << std::endl;
+    return 2;
+}
+catch (...)
+{
+    cerr << "unknown error" << std::endl;
+    return -1;
+}
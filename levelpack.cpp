@@ -0,0 +1,229 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+
+#include "levelpack.h"
+#include "random.h"
+#include <fstream>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(LevelPack::Header)==16 && sizeof(LevelPack::Entry)==72, "level pack structs must not have padding");
+
+LevelPack::LevelPack(const filesystem::path& file) :
+    path(file),
+    data(nullptr),
+    dataSize(0),
+    entries(),
+#ifdef _WIN32
+    fileHandle(INVALID_HANDLE_VALUE),
+    mappingHandle(nullptr)
+#else
+    fileHandle(-1)
+#endif
+{
+    auto fail=[this](const string& what) {
+        unmap();
+        throw runtime_error(what+" '"+path.string()+"'");
+    };
+
+#ifdef _WIN32
+    fileHandle=CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle==INVALID_HANDLE_VALUE) fail("Failed to open level pack");
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) fail("Failed to read size of level pack");
+    dataSize=size_t(fileSize.QuadPart);
+    if (dataSize<sizeof(Header)) fail("Level pack too small");
+    mappingHandle=CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) fail("Failed to map level pack");
+    data=static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!data) fail("Failed to map level pack");
+#else
+    fileHandle=open(file.c_str(), O_RDONLY);
+    if (fileHandle<0) fail("Failed to open level pack");
+    struct stat info;
+    if (fstat(fileHandle, &info)!=0) fail("Failed to read size of level pack");
+    dataSize=size_t(info.st_size);
+    if (dataSize<sizeof(Header)) fail("Level pack too small");
+    auto mapping=mmap(nullptr, dataSize, PROT_READ, MAP_PRIVATE, fileHandle, 0);
+    if (mapping==MAP_FAILED) fail("Failed to map level pack");
+    data=static_cast<const uint8_t*>(mapping);
+#endif
+
+    // the cells are used as they are, only the directory and brick counts are checked
+    auto header=reinterpret_cast<const Header*>(data);
+    if (memcmp(header->magic, Magic, sizeof(Magic))!=0) fail("Not a level pack");
+    if (header->version!=Version) fail("Unsupported level pack version "+to_string(header->version)+" in");
+    if (header->levelCount==0) fail("No levels in level pack");
+    if (header->levelCount>(dataSize-sizeof(Header))/sizeof(Entry)) fail("Truncated level pack");
+
+    entries=span(reinterpret_cast<const Entry*>(data+sizeof(Header)), header->levelCount);
+    for (auto&& e : entries)
+    {
+        auto cellCount=uint64_t(e.columns)*e.rows;
+        if (e.name[MaxNameLength]!=0 || e.offset>dataSize || cellCount>dataSize-e.offset) fail("Corrupt level pack");
+        if (e.destructibleBricks==0) fail("Level '"+string(e.name)+"' has nothing to destroy in level pack");
+        if (e.destructibleBricks!=Level::countDestructible(span(data+e.offset, size_t(cellCount)))) fail("Wrong brick count for level '"+string(e.name)+"' in level pack");
+    }
+}
+
+LevelPack::~LevelPack()
+{
+    unmap();
+}
+
+void LevelPack::unmap() noexcept
+{
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle!=INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+    mappingHandle=nullptr;
+    fileHandle=INVALID_HANDLE_VALUE;
+#else
+    if (data) munmap(const_cast<uint8_t*>(data), dataSize);
+    if (fileHandle>=0) close(fileHandle);
+    fileHandle=-1;
+#endif
+    data=nullptr;
+    entries={};
+}
+
+Level::Layout LevelPack::getLayout(size_t index) const noexcept
+{
+    const auto& e=entries[index];
+    return {
+        e.columns,
+        e.rows,
+        size_t(e.destructibleBricks),
+        span(data+e.offset, size_t(e.columns)*e.rows)
+    };
+}
+
+size_t LevelPack::getMaxCellCount() const noexcept
+{
+    size_t result=0;
+    for (auto&& e : entries) result=max<size_t>(result, size_t(e.columns)*e.rows);
+    return result;
+}
+
+LevelPack::Source LevelPack::parseText(const filesystem::path& file)
+{
+    string line;
+    auto in=ifstream(file);
+    if (!in) throw runtime_error("Failed to open level '"+file.string()+"'");
+
+    vector<string> lines;
+    while (getline(in, line))
+    {
+        if (!line.empty() && line.back()=='\r') line.pop_back();
+        lines.push_back(line);
+    }
+
+    Source level;
+    level.name=file.stem().string().substr(0, MaxNameLength);
+    level.rows=static_cast<uint32_t>(lines.size());
+    for (auto&& l : lines) level.columns=max(level.columns, static_cast<uint32_t>(l.size()));
+    level.cells.resize(size_t(level.columns)*level.rows, Level::makeCell(Level::Empty, 0));
+
+    for (size_t row=0; row<lines.size(); ++row)
+    {
+        for (size_t column=0; column<lines[row].size(); ++column)
+        {
+            char c=lines[row][column];
+            auto& cell=level.cells[row*level.columns+column];
+            if (c==' ') continue;
+            else if (c=='S') cell=Level::makeCell(Level::Silver, 2);
+            else if (c=='X') cell=Level::makeCell(Level::Solid, Level::SolidHp);
+            else if (c>='1' && c<='8') cell=Level::makeCell(Level::BrickType(c-'0'), 1);
+            else throw runtime_error("Unknown brick '"s+c+"' in level '"+file.string()+"'");
+        }
+    }
+    return level;
+}
+
+LevelPack::Source LevelPack::generate(const GeneratorSettings& settings)
+{
+    if (settings.columns==0 || settings.rows==0 || settings.columns>MaxGeneratedSize || settings.rows>MaxGeneratedSize)
+    {
+        throw runtime_error("Generated levels must have 1 to "+to_string(MaxGeneratedSize)+" columns and rows");
+    }
+    auto checkFraction=[](const char* name, float value) {
+        if (!(value>=0.0f && value<=1.0f)) throw runtime_error("Generator "s+name+" must be between 0 and 1, not "+to_string(value));
+    };
+    checkFraction("density", settings.density);
+    checkFraction("solid", settings.solid);
+    checkFraction("silver", settings.silver);
+    if (settings.solid+settings.silver>1.0f) throw runtime_error("Generator solid and silver must not add up to more than 1");
+    if (settings.density==0.0f || settings.solid==1.0f)
+    {
+        throw runtime_error("Generated levels need a density above 0 and fewer than all bricks solid");
+    }
+
+    Source level;
+    level.name=to_string(settings.columns)+"x"+to_string(settings.rows)+"_"+to_string(settings.seed);
+    level.columns=settings.columns;
+    level.rows=settings.rows;
+    level.cells.resize(size_t(level.columns)*level.rows, Level::makeCell(Level::Empty, 0));
+
+    Random rng(settings.seed);
+    for (uint32_t row=0; row<level.rows; ++row)
+    {
+        auto band=Level::BrickType(1+uint64_t(row)*8/level.rows);
+        for (uint32_t column=0; column<level.columns; ++column)
+        {
+            if (rng.nextFloat()>=settings.density) continue;
+
+            auto kind=rng.nextFloat();
+            auto& cell=level.cells[size_t(row)*level.columns+column];
+            if (kind<settings.solid) cell=Level::makeCell(Level::Solid, Level::SolidHp);
+            else if (kind<settings.solid+settings.silver) cell=Level::makeCell(Level::Silver, 2);
+            else cell=Level::makeCell(band, 1);
+        }
+    }
+    return level;
+}
+
+void LevelPack::write(const filesystem::path& file, span<const Source> levels)
+{
+    // checked before the file is touched, so a bad level leaves no broken pack behind
+    for (auto&& l : levels)
+    {
+        if (Level::countDestructible(l.cells)==0) throw runtime_error("Level '"+l.name+"' has no bricks that can be destroyed");
+    }
+
+    auto out=ofstream(file, ios::binary);
+    if (!out) throw runtime_error("Failed to open level pack '"+file.string()+"'");
+
+    Header header={};
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version=Version;
+    header.levelCount=static_cast<uint32_t>(levels.size());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    uint64_t offset=sizeof(Header)+levels.size()*sizeof(Entry);
+    for (auto&& l : levels)
+    {
+        Entry entry={};
+        memcpy(entry.name, l.name.data(), min(l.name.size(), MaxNameLength));
+        entry.columns=l.columns;
+        entry.rows=l.rows;
+        entry.offset=offset;
+        entry.destructibleBricks=Level::countDestructible(l.cells);
+        out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        offset+=l.cells.size();
+    }
+    for (auto&& l : levels) out.write(reinterpret_cast<const char*>(l.cells.data()), l.cells.size());
+
+    if (!out) throw runtime_error("Failed to write level pack '"+file.string()+"'");
+}
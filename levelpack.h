@@ -0,0 +1,94 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#pragma once
+
+#include "common.h"
+#include "level.h"
+#include <span>
+
+//! @brief all levels of the game compiled into one file (see levelc.cpp).
+//! The file is memory mapped and the levels are handed out straight from
+//! the mapping, nothing is parsed at load time. Layout, all little endian:
+//!   Header, Entry[levelCount], then the cells of every level (one byte each,
+//!   row by row, see Level::Cell) at the offset given in its entry.
+class LevelPack
+{
+public:
+    static constexpr char Magic[4] = { 'B', 'O', 'L', 'P' };
+    static constexpr uint32_t Version = 1;
+    static constexpr size_t MaxNameLength = 47;
+    static constexpr uint32_t MaxGeneratedSize = 1000;
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t levelCount;
+        uint32_t reserved;
+    };
+
+    struct Entry
+    {
+        char name[MaxNameLength+1];     // zero terminated
+        uint32_t columns;
+        uint32_t rows;
+        uint64_t offset;                // of the cells from the start of the file
+        uint64_t destructibleBricks;
+    };
+
+    //! a level before it is written to a pack
+    struct Source
+    {
+        string name;
+        uint32_t columns = 0;
+        uint32_t rows = 0;
+        vector<Level::Cell> cells;
+    };
+
+    //! @brief settings for generated stress test levels. Bricks get the
+    //! colors in bands from top to bottom like the hand made levels.
+    struct GeneratorSettings
+    {
+        uint32_t columns = 13;
+        uint32_t rows = 8;
+        float density = 0.8f;   // chance of a cell holding a brick
+        float solid = 0.05f;    // chance of a brick being solid
+        float silver = 0.1f;    // chance of a brick being silver
+        uint64_t seed = 1;
+    };
+
+public:
+    LevelPack(const filesystem::path& file);
+    ~LevelPack();
+
+    LevelPack(const LevelPack& rhs) = delete;
+    LevelPack& operator=(const LevelPack& rhs) = delete;
+
+    inline size_t size() const noexcept { return entries.size(); }
+    inline string_view getName(size_t index) const noexcept { return entries[index].name; }
+    Level::Layout getLayout(size_t index) const noexcept;
+    //! the size of the largest level, in cells
+    size_t getMaxCellCount() const noexcept;
+
+    //! read a text level: one character per cell, ' ' empty, 1-8 colored, S silver, X solid
+    static Source parseText(const filesystem::path& file);
+    static Source generate(const GeneratorSettings& settings);
+    //! every level needs a brick that can be destroyed, a level without one would be
+    //! complete right away and the game would skip through levels every tick
+    static void write(const filesystem::path& file, span<const Source> levels);
+
+private:
+    filesystem::path path;
+    const uint8_t* data;
+    size_t dataSize;
+    span<const Entry> entries;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileHandle;
+#endif
+
+    void unmap() noexcept;
+};
@@ -11,16 +11,43 @@
 #include "buffermanager.h"
 #include "swapchain.h"
 #include "imagerendertarget.h"
+#include "framegraph.h"
+#include "resolutioncontroller.h"
 #include "postprocess.h"
 #include "game.h"
+#include "gameview.h"
+#include "jobsystem.h"
+#include "profiler.h"
+#include "replay.h"
 #include <glm/glm.hpp>
 
 #include <SDL3/SDL.h>
 #include <chrono>
+#include <random>
 
 using GameClock = chrono::high_resolution_clock;
 using Seconds = chrono::duration<float>;
 
+static constexpr const char* DefaultTraceFile = "breakout_trace.json";
+
+//! drive the simulation with recorded input as fast as possible, without window or device
+static void playReplay(const Replay& replay, const filesystem::path& levels)
+{
+    Game game(levels, replay.getSeed());
+    auto start=GameClock::now();
+    for (auto&& tick : replay.getTicks())
+    {
+        game.setInput(tick.input);
+        game.processInput(tick.dt);
+        game.update(tick.dt);
+        game.clearEvents();     // nobody to see or hear them
+    }
+    auto elapsed=chrono::duration_cast<Seconds>(GameClock::now()-start).count();
+
+    cout << format("replayed {} ticks ({:.1f}s of play) in {:.3f}s, {:.0f} ticks/s, final score {}\n",
+        replay.getTicks().size(), replay.getDuration(), elapsed, double(replay.getTicks().size())/elapsed, game.getScore());
+}
+
 //!@brief
 //!
 //!@param argc
@@ -28,13 +55,46 @@ using Seconds = chrono::duration<float>;
 //!@return int
 int main(int argc, char* argv[])
 try {
+    // Step 0: parse command line
+    filesystem::path traceFile;
+    size_t traceFrames=Profiler::MaxFrames;
+    bool printStats=false;
+    filesystem::path recordFile;
+    optional<Replay> replay;
+    uint64_t seed=random_device{}();
+    filesystem::path levels="levels.pack";
+    uint32_t msaa=4;
+    float renderScale=1.0f;
+    optional<double> sceneBudget;
+    for (int i=1; i<argc; ++i)
+    {
+        auto arg=string_view(argv[i]);
+        if (arg=="--trace" && i+1<argc) traceFile=argv[++i];
+        else if (arg=="--trace-frames" && i+1<argc) traceFrames=stoul(argv[++i]);
+        else if (arg=="--stats") printStats=true;
+        else if (arg=="--seed" && i+1<argc) seed=stoull(argv[++i]);
+        else if (arg=="--record" && i+1<argc) recordFile=argv[++i];
+        else if (arg=="--replay" && i+1<argc) replay=Replay::load(argv[++i]);
+        else if (arg=="--levels" && i+1<argc) levels=argv[++i];
+        else if (arg=="--msaa" && i+1<argc) msaa=stoul(argv[++i]);
+        else if (arg=="--render-scale" && i+1<argc) renderScale=stof(argv[++i])/100.0f;
+        else if (arg=="--dynamic-resolution" && i+1<argc) sceneBudget=stod(argv[++i])*1000.0;
+        else throw runtime_error("unknown argument '"s+argv[i]+"'. Usage: breakout [--trace file.json] [--trace-frames N] [--stats] [--seed N] [--levels file] [--msaa N] [--render-scale percent] [--dynamic-resolution ms] [--record file | --replay file]");
+    }
+    if (replay)
+    {
+        playReplay(*replay, levels);
+        return 0;
+    }
+    auto recording=Replay(seed);
+
     // Step 1: initialize graphics
     // Step 1.1: initialize SDL
     SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
     auto window = SDL_CreateWindow(
         "Break Out Volcano !!",
-        Game::LogicalSize.x*16,
-        Game::LogicalSize.y*16,
+        GameView::LogicalSize.x*16,
+        GameView::LogicalSize.y*16,
         SDL_WINDOW_RESIZABLE | 
         SDL_WINDOW_HIGH_PIXEL_DENSITY |
         SDL_WINDOW_VULKAN
@@ -54,13 +114,15 @@ try {
             vk::KHRSwapchainExtensionName,
             vk::KHRSpirv14ExtensionName,
             vk::KHRSynchronization2ExtensionName,
-            vk::KHRCreateRenderpass2ExtensionName
+            vk::KHRCreateRenderpass2ExtensionName,
+            vk::KHRPushDescriptorExtensionName
         },
-        vk::PhysicalDeviceFeatures2{.features = {.samplerAnisotropy = true} },   // vk::PhysicalDeviceFeatures2 
+        vk::PhysicalDeviceFeatures2{.features = {.samplerAnisotropy = true, .textureCompressionBC = true} },   // compression is dropped when unsupported, see Vulkan::getEnabledFeatures
         vk::PhysicalDeviceVulkan11Features{.shaderDrawParameters = true },  // Enable shader draw parameters
         vk::PhysicalDeviceVulkan12Features{
             .shaderInt8 = true,
-            .storagePushConstant8 = true
+            .storagePushConstant8 = true,
+            .timelineSemaphore = true       // frame pacing, see Vulkan::getFrameTimeline
         },
         vk::PhysicalDeviceVulkan13Features{
             .dynamicRendering = true,      // Enable dynamic rendering from Vulkan 1.3
@@ -69,44 +131,60 @@ try {
         vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT{.extendedDynamicState = true }   // Enable extended dynamic state from the extension}
     );
 
-    auto swapChain=make_unique<SwapChain>(2);
+    // the scene is rendered with these settings and scaled to the swapchain by PostProcess
+    auto samples=getSupportedSampleCount(vulkan.getPhysicalDevice(), msaa);
+    renderScale=clamp(renderScale, ImageRenderTarget::MinRenderScale, ImageRenderTarget::MaxRenderScale);
+
+    auto swapChain=make_unique<SwapChain>();
     auto images=make_unique<ImageRenderTarget>();
     swapChain->reset();
-    images->reset(swapChain->getDescription(), 2);
-    auto postprocess=make_unique<PostProcess>();
+    // the scene images are only resolve targets, the MSAA attachment comes from the frame graph
+    images->reset(swapChain->getDescription(), FramesInFlight, vk::SampleCountFlagBits::e1, renderScale);
+    auto frameGraph=make_unique<FrameGraph>();
+    auto postprocess=make_unique<PostProcess>(swapChain->getUsage());
+    profiler.initializeGpu(swapChain->getFramesInFlight());
 
     // Step 2: initialize Game
-    auto breakout = make_unique<Game>("levels");
-    breakout->updateScreenSize(swapChain->getDescription().extent);
+    auto jobs = make_unique<JobSystem>();
+    auto breakout = make_unique<Game>(levels, seed, jobs.get());
+    auto view = make_unique<GameView>(*breakout, *postprocess, *jobs, seed);
+    view->updateScreenSize(images->getDescription().extent, samples);
+
+    // with a budget for the scene's GPU time, renderScale is only the upper limit
+    optional<ResolutionController> dynamicResolution;
+    if (sceneBudget) dynamicResolution.emplace(*sceneBudget, ImageRenderTarget::MinRenderScale, renderScale);
+
+    // the scene target follows the swapchain and the render settings
+    auto resetScene=[&] {
+        images->reset(swapChain->getDescription(), FramesInFlight, vk::SampleCountFlagBits::e1, renderScale);
+        view->updateScreenSize(images->getDescription().extent, samples);
+        if (dynamicResolution)
+        {
+            dynamicResolution->setBounds(ImageRenderTarget::MinRenderScale, renderScale);
+            images->setRenderScale(dynamicResolution->getScale());
+        }
+    };
 
     // Step 3: Run game loop
     auto lastFrame=GameClock::now();
     bool done=false;
     SDL_Event event;
     bool paused=false;
+    Game::Snapshot quickSave;
 
     while (!done)
     {
-        // Step 3.1: wait until we are ready for next frame (present has finished)
-        if (swapChain->waitForNextFrame())
-        {
-            // we need a reset
-            swapChain->reset();
-            images->reset(swapChain->getDescription(), 2);
-            breakout->updateScreenSize(swapChain->getDescription().extent);
-            continue;
-        }
+        profiler.beginFrame();
 
-        bool restartLoop=false;
+        // Step 3.1: handle events. A resize recreates the swapchain right here, between
+        // frames no image is acquired and the old chain is handed to the new one
+        bool resized=false;
         while (SDL_PollEvent(&event))
         {
             switch (event.type)
             {
             case SDL_EVENT_WINDOW_RESIZED:
-                swapChain->reset();
-                images->reset(swapChain->getDescription(), 2);
-                breakout->updateScreenSize(swapChain->getDescription().extent);
-                restartLoop=true;
+                resized=true;
                 break;
 
             case SDL_EVENT_QUIT:
@@ -131,68 +209,164 @@ try {
                 
 
             case SDL_EVENT_KEY_DOWN:
-                breakout->setKey(event.key.scancode, true);
+                view->setKey(event.key.scancode, true);
                 if (event.key.scancode==SDL_SCANCODE_ESCAPE) done=true;
+                if (event.key.scancode==SDL_SCANCODE_F12)
+                {
+                    profiler.writeChromeTrace(traceFile.empty() ? DefaultTraceFile : traceFile, traceFrames);
+                }
+                if (!event.key.repeat && (event.key.scancode==SDL_SCANCODE_F6 || event.key.scancode==SDL_SCANCODE_F7 || event.key.scancode==SDL_SCANCODE_F8))
+                {
+                    // F6 cycles through 1x, 2x, 4x and 8x MSAA, F7 and F8 step the render scale
+                    if (event.key.scancode==SDL_SCANCODE_F6)
+                    {
+                        auto next=uint32_t(samples)*2;
+                        samples=getSupportedSampleCount(vulkan.getPhysicalDevice(), next);
+                        if (uint32_t(samples)!=next || next>8) samples=vk::SampleCountFlagBits::e1;
+                    }
+                    if (event.key.scancode==SDL_SCANCODE_F7) renderScale=max(renderScale-0.25f, ImageRenderTarget::MinRenderScale);
+                    if (event.key.scancode==SDL_SCANCODE_F8) renderScale=min(renderScale+0.25f, ImageRenderTarget::MaxRenderScale);
+                    resetScene();
+                }
+                if (event.key.scancode==SDL_SCANCODE_F5) breakout->save(quickSave);
+                if (event.key.scancode==SDL_SCANCODE_F9 && quickSave.size()>0)
+                {
+                    // a replay only holds input, it can't jump back in time
+                    if (recordFile.empty()) breakout->restore(quickSave);
+                    else cerr << "quick load is disabled while recording" << endl;
+                }
                 break;
 
             case SDL_EVENT_KEY_UP:
-                breakout->setKey(event.key.scancode, false);
+                view->setKey(event.key.scancode, false);
 
             default: break;
             }
         }
 
-        if (restartLoop)
+        if (paused)
         {
+            SDL_WaitEventTimeout(nullptr, 250);
             continue;
         }
-        
-        if (paused)
+
+        if (resized)
         {
-            SDL_WaitEventTimeout(nullptr, 250);
+            swapChain->reset();
+            resetScene();
+        }
+
+        // Step 3.2: wait until we are ready for next frame (present has finished)
+        bool needsReset;
+        {
+            PROFILE_ZONE("SwapChain::waitForNextFrame");
+            needsReset=swapChain->waitForNextFrame();
+        }
+        if (needsReset)
+        {
+            // we need a reset
+            swapChain->reset();
+            resetScene();
             continue;
         }
 
-        // Step 3.2: process input and update game state
+        // Step 3.3: process input and update game state
         auto currentFrame = GameClock::now();
         auto deltaTime = chrono::duration_cast<Seconds>(currentFrame-lastFrame);
         lastFrame = currentFrame;
 
-        breakout->processInput(deltaTime.count());
-        breakout->update(deltaTime.count(), *postprocess);
+        if (!recordFile.empty()) recording.record(deltaTime.count(), view->getInput());
+        view->processInput(deltaTime.count());
+        view->update(deltaTime.count());
         postprocess->update(deltaTime.count());
         
-        // Step 3.3: render frame 
+        // Step 3.4: render frame 
         auto& commandBuffer = swapChain->beginFrame();
+        profiler.beginGpuFrame(commandBuffer, swapChain->getCurrentFrame());
 
-        // Step 3.1.1: draw frame into image buffer
-        images->beginRenderTo(commandBuffer, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f));
-        breakout->draw(commandBuffer);
-        images->endRenderTo(commandBuffer);
-        images->getCurrent().transition(commandBuffer, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead, vk::ImageLayout::eShaderReadOnlyOptimal);
+        // the latest scene timing has just been collected, changing the scale costs nothing
+        if (dynamicResolution)
+        {
+            auto sceneTime=profiler.getLatestGpuZoneTime("Scene");
+            if (sceneTime && dynamicResolution->update(sceneTime->frame, sceneTime->time)) images->setRenderScale(dynamicResolution->getScale());
+        }
 
+        // Step 3.3.1: describe the frame, the graph records the barriers and provides the MSAA attachment
+        frameGraph->reset();
+        auto scene=frameGraph->importImage("scene", images->getCurrent());
+        auto screen=frameGraph->importImage("screen", swapChain->getCurrent(), true);
+        auto sceneMsaa=samples!=vk::SampleCountFlagBits::e1 ? frameGraph->createTransient("scene msaa", images->getDescription(), samples) : FrameGraph::None;
 
-        // step 3.1.2: draw image buffer into frame buffer using effects
-        swapChain->beginRenderTo(commandBuffer, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f));
-        postprocess->draw(commandBuffer, images->getCurrent());
-        swapChain->endRenderTo(commandBuffer);
+        // draw frame into image buffer
+        frameGraph->addPass("Scene",
+            [&](FrameGraph::PassBuilder& pass) {
+                pass.write(sceneMsaa, FrameGraph::Usage::ColorAttachment);
+                pass.write(scene, FrameGraph::Usage::ColorAttachment);
+            },
+            [&](const vk::CommandBuffer& buffer) {
+                view->prepareDraw(buffer);
+                auto color=sceneMsaa!=FrameGraph::None ? sceneMsaa : scene;
+                auto resolve=sceneMsaa!=FrameGraph::None ? scene : FrameGraph::None;
+                frameGraph->beginRendering(buffer, color, resolve, images->getRenderExtent(), vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f));
+                view->draw(buffer);
+                buffer.endRendering();
+            }
+        );
+
+        // draw image buffer into frame buffer using effects, or copy it over if there are none
+        if (postprocess->isPassNeeded())
+        {
+            frameGraph->addPass("PostProcess",
+                [&](FrameGraph::PassBuilder& pass) {
+                    pass.read(scene, FrameGraph::Usage::Sampled);
+                    pass.write(screen, FrameGraph::Usage::ColorAttachment);
+                },
+                [&](const vk::CommandBuffer& buffer) {
+                    frameGraph->beginRendering(buffer, screen, FrameGraph::None, swapChain->getDescription().extent, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f));
+                    postprocess->draw(buffer, images->getCurrent(), images->getRenderExtent());
+                    buffer.endRendering();
+                }
+            );
+        }
+        else
+        {
+            frameGraph->addPass("Blit",
+                [&](FrameGraph::PassBuilder& pass) {
+                    pass.read(scene, FrameGraph::Usage::TransferSrc);
+                    pass.write(screen, FrameGraph::Usage::TransferDst);
+                },
+                [&](const vk::CommandBuffer& buffer) {
+                    postprocess->blit(buffer, images->getCurrent(), images->getRenderExtent(), swapChain->getCurrent());
+                }
+            );
+        }
+        frameGraph->execute(commandBuffer);
         images->cycle();
 
-        // Step 3.4: present frame to screen
+        // Step 3.5: present frame to screen
+        profiler.submitFrame();
         if (swapChain->endFrame(commandBuffer))
         {
             swapChain->reset();
-            images->reset(swapChain->getDescription(), 2);
-            breakout->updateScreenSize(swapChain->getDescription().extent);
+            resetScene();
         }
+        profiler.endFrame();
     }
 
     vulkan.getDevice().waitIdle();
 
+    if (!recordFile.empty()) recording.save(recordFile);
+    if (!traceFile.empty()) profiler.writeChromeTrace(traceFile, traceFrames);
+    if (printStats) profiler.writeSummary(cout, traceFrames);
+
+    view=nullptr;
     breakout=nullptr;
+    jobs=nullptr;
     postprocess=nullptr;
+    frameGraph=nullptr;
     images=nullptr;
     swapChain=nullptr;
+    profiler.cleanup();
     
     vulkan.cleanup();
  
@@ -20,37 +20,22 @@ ParticleSystemBase::ParticleSystemBase(
     descriptorPool(nullptr),
     descriptors(nullptr),
     image(createImageFromFile(texture, vulkan.getBufferManager())),
-    sampler(createSampler(vulkan.getPhysicalDevice(), vulkan.getDevice())),
+    sampler(vulkan.getRegistry().getSampler()),
     transformation(1.0f)
 {
+    // every particle system has its own texture, but they all share the pipeline
+    auto& registry=vulkan.getRegistry();
     DescriptorSetBuilder descBuilder;
     descBuilder.bindings.emplace_back(0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment);
-    tie(descriptorLayout, descriptorPool, descriptors)=descBuilder.buildLayoutAndSets(vulkan.getDevice(), 1);
+    descriptorLayout=registry.getDescriptorSetLayout(descBuilder);
+    tie(descriptorPool, descriptors)=descBuilder.buildPoolAndSets(vulkan.getDevice(), descriptorLayout, 1);
 
     PipelineLayoutBuilder layoutBuilder;
     layoutBuilder.descriptorSets.push_back(descriptorLayout);
     layoutBuilder.pushConstants.emplace_back(vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::mat4)+sizeof(ParticlePushData));
-    pipelineLayout=layoutBuilder.build(vulkan.getDevice());
+    pipelineLayout=registry.getPipelineLayout(layoutBuilder);
 
-    PipelineBuilder builder;
-    auto shaderModule=loadShaderModule(vulkan.getDevice(), "shaders/particles.spv");        
-    builder.shaders.push_back({ .stage=vk::ShaderStageFlagBits::eVertex, .module=shaderModule, .pName="vertMain"});
-    builder.inputAssembly.topology = vk::PrimitiveTopology::eTriangleStrip;
-    builder.shaders.push_back({ .stage=vk::ShaderStageFlagBits::eFragment, .module=shaderModule, .pName="fragMain"});
-
-    builder.multisample.rasterizationSamples = vk::SampleCountFlagBits::e4;
-
-    builder.addColorAttachment(
-        vulkan.getSwapChainFormat().format,
-        vk::PipelineColorBlendAttachmentState{
-            .blendEnable = true,
-            .colorBlendOp = vk::BlendOp::eAdd,
-            .srcColorBlendFactor = vk::BlendFactor::eSrcAlpha,
-            .dstColorBlendFactor = vk::BlendFactor::eOne,
-            .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB
-        }
-    );
-    pipeline = builder.build(vulkan.getDevice(),pipelineLayout);
+    setSamples(vk::SampleCountFlagBits::e4);
 
     auto imageInfo = vk::DescriptorImageInfo
     {
@@ -71,4 +56,28 @@ ParticleSystemBase::ParticleSystemBase(
     vulkan.getDevice().updateDescriptorSets(descriptorWrites, {});
 }
 
+void ParticleSystemBase::setSamples(vk::SampleCountFlagBits samples)
+{
+    auto& registry=vulkan.getRegistry();
+    PipelineBuilder builder;
+    auto shaderModule=registry.getShaderModule("shaders/particles.spv");        
+    builder.shaders.push_back({ .stage=vk::ShaderStageFlagBits::eVertex, .module=shaderModule, .pName="vertMain"});
+    builder.inputAssembly.topology = vk::PrimitiveTopology::eTriangleStrip;
+    builder.shaders.push_back({ .stage=vk::ShaderStageFlagBits::eFragment, .module=shaderModule, .pName="fragMain"});
+
+    builder.multisample.rasterizationSamples = samples;
+
+    builder.addColorAttachment(
+        vulkan.getSwapChainFormat().format,
+        vk::PipelineColorBlendAttachmentState{
+            .blendEnable = true,
+            .colorBlendOp = vk::BlendOp::eAdd,
+            .srcColorBlendFactor = vk::BlendFactor::eSrcAlpha,
+            .dstColorBlendFactor = vk::BlendFactor::eOne,
+            .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB
+        }
+    );
+    pipeline = registry.getPipeline(builder, pipelineLayout);
+}
+
 } // end namespace detail
\ No newline at end of file
@@ -5,6 +5,8 @@
 
 #include "common.h"
 #include "texture.h"
+#include "jobsystem.h"
+#include "profiler.h"
 #include <glm/glm.hpp>
 
 namespace detail
@@ -25,14 +27,17 @@ public:
 public:
     ParticleSystemBase(const filesystem::path& texture);
 
+    //! selects the pipeline for render targets with this many samples
+    void setSamples(vk::SampleCountFlagBits samples);
+
 protected:
-    vk::raii::PipelineLayout pipelineLayout;
-    vk::raii::Pipeline pipeline;
-    vk::raii::DescriptorSetLayout descriptorLayout;
+    vk::PipelineLayout pipelineLayout;      // shared through PipelineRegistry
+    vk::Pipeline pipeline;
+    vk::DescriptorSetLayout descriptorLayout;
     vk::raii::DescriptorPool descriptorPool;
     vk::raii::DescriptorSets descriptors;
     DeviceImage image;
-    vk::raii::Sampler sampler;
+    vk::Sampler sampler;
     glm::mat4 transformation;
 };
 
@@ -42,6 +47,8 @@ template<typename UserData=detail::Empty>
 class ParticleSystem : private detail::ParticleSystemBase
 {
 public:
+    //! small enough that the trail (up to 248 particles) and brick fragments (128) are split
+    static constexpr size_t ParallelGrainSize = 64;
 
     struct Particle : public ParticlePushData, public UserData
     {
@@ -58,6 +65,8 @@ public:
     };
 
 public:
+    using ParticleSystemBase::setSamples;
+
     ParticleSystem(size_t maxParticles, const filesystem::path& texture) :
         ParticleSystemBase(texture),
         particles(maxParticles),
@@ -103,6 +112,19 @@ public:
         }
     }
 
+    //! same as above, but spreads the particles over the job system.
+    //! update must be safe to call concurrently for different particles.
+    void update(float dt, const auto& update, JobSystem& jobs)
+    {
+        jobs.parallelFor(particles.size(), ParallelGrainSize, [&](size_t begin, size_t end) {
+            for (auto p=particles.begin()+begin; p!=particles.begin()+end; ++p)
+            {
+                p->life-=dt;
+                if (p->life>0.0f) update(*p);
+            }
+        });
+    }
+
     void update(float dt)
     {
         for (auto& p : particles)
@@ -111,8 +133,9 @@ public:
         }
     }
 
-    void draw(const vk::CommandBuffer& buffer) const
+    void draw(const vk::CommandBuffer& commandBuffer) const
     {
+        CountingCommandBuffer buffer(commandBuffer, Profiler::Particles);
         buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
         buffer.pushConstants<glm::mat4>(pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, transformation);
         buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, *descriptors[0], {});
@@ -4,14 +4,14 @@
 
 #include "pipelinebuilder.h"
 
-vk::raii::DescriptorSetLayout DescriptorSetBuilder::buildLayout(const vk::raii::Device& device)
+vk::raii::DescriptorSetLayout DescriptorSetBuilder::buildLayout(const vk::raii::Device& device) const
 {
     auto layoutInfo = vk::DescriptorSetLayoutCreateInfo{ .flags=layoutFlags };
     layoutInfo.setBindings(bindings);
     return vk::raii::DescriptorSetLayout(device, layoutInfo);
 }
 
-vk::raii::DescriptorPool DescriptorSetBuilder::buildPool(const vk::raii::Device& device, size_t setCount)
+vk::raii::DescriptorPool DescriptorSetBuilder::buildPool(const vk::raii::Device& device, size_t setCount) const
 {
     auto poolInfo = vk::DescriptorPoolCreateInfo{ .flags=poolFlags };
     poolInfo.setMaxSets(setCount);
@@ -21,20 +21,27 @@ vk::raii::DescriptorPool DescriptorSetBuilder::buildPool(const vk::raii::Device&
     return vk::raii::DescriptorPool(device, poolInfo);
 }
 
-tuple<vk::raii::DescriptorSetLayout, vk::raii::DescriptorPool, vk::raii::DescriptorSets>
-DescriptorSetBuilder::buildLayoutAndSets(const vk::raii::Device& device, size_t setCount)
+tuple<vk::raii::DescriptorPool, vk::raii::DescriptorSets>
+DescriptorSetBuilder::buildPoolAndSets(const vk::raii::Device& device, vk::DescriptorSetLayout layout, size_t setCount) const
 {
-    auto layout=buildLayout(device);
     auto pool=buildPool(device, setCount);
-    auto layouts=vector<vk::DescriptorSetLayout>(setCount, *layout);
+    auto layouts=vector<vk::DescriptorSetLayout>(setCount, layout);
     auto allocInfo=vk::DescriptorSetAllocateInfo{.descriptorPool=pool};
     allocInfo.setSetLayouts(layouts);
     auto descriptorSets=vk::raii::DescriptorSets(device, allocInfo);
+    return make_tuple(std::move(pool), std::move(descriptorSets));
+}
+
+tuple<vk::raii::DescriptorSetLayout, vk::raii::DescriptorPool, vk::raii::DescriptorSets>
+DescriptorSetBuilder::buildLayoutAndSets(const vk::raii::Device& device, size_t setCount) const
+{
+    auto layout=buildLayout(device);
+    auto [pool, descriptorSets]=buildPoolAndSets(device, layout, setCount);
     return make_tuple(std::move(layout), std::move(pool), std::move(descriptorSets));
 
 }
 
-vk::raii::PipelineLayout PipelineLayoutBuilder::build(const vk::raii::Device& device)
+vk::raii::PipelineLayout PipelineLayoutBuilder::build(const vk::raii::Device& device) const
 {
     auto pipelineLayoutInfo = vk::PipelineLayoutCreateInfo{};
     pipelineLayoutInfo.setSetLayouts(descriptorSets);
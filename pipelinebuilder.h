@@ -12,11 +12,15 @@ struct DescriptorSetBuilder
 
     vk::DescriptorPoolCreateFlags poolFlags=vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
 
-    vk::raii::DescriptorSetLayout buildLayout(const vk::raii::Device& device);
-    vk::raii::DescriptorPool buildPool(const vk::raii::Device& device, size_t setCount);
+    vk::raii::DescriptorSetLayout buildLayout(const vk::raii::Device& device) const;
+    vk::raii::DescriptorPool buildPool(const vk::raii::Device& device, size_t setCount) const;
+
+    //! sets for a layout of the same bindings, e.g. from PipelineRegistry
+    tuple<vk::raii::DescriptorPool, vk::raii::DescriptorSets>
+    buildPoolAndSets(const vk::raii::Device& device, vk::DescriptorSetLayout layout, size_t setCount) const;
 
     tuple<vk::raii::DescriptorSetLayout, vk::raii::DescriptorPool, vk::raii::DescriptorSets>
-    buildLayoutAndSets(const vk::raii::Device& device, size_t setCount);
+    buildLayoutAndSets(const vk::raii::Device& device, size_t setCount) const;
 };
 
 
@@ -25,7 +29,7 @@ struct PipelineLayoutBuilder
     vector<vk::DescriptorSetLayout> descriptorSets = {};
     vector<vk::PushConstantRange> pushConstants = {};
 
-    vk::raii::PipelineLayout build(const vk::raii::Device& device);
+    vk::raii::PipelineLayout build(const vk::raii::Device& device) const;
 };
 
 struct PipelineBuilder
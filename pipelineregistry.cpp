@@ -0,0 +1,101 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+
+#include "pipelineregistry.h"
+#include "vkutils.h"
+
+PipelineRegistry::PipelineKey::PipelineKey(const PipelineBuilder& builder, vk::PipelineLayout layout) :
+    layout(layout),
+    flags(builder.flags),
+    shaders(),
+    vertexInputBindings(builder.vertexInputBindings),
+    vertexInputAttributes(builder.vertexInputAttributes),
+    inputAssembly(builder.inputAssembly),
+    tessellation(builder.tessellation),
+    viewports(builder.viewports),
+    scissors(builder.scissors),
+    rasterization(builder.rasterization),
+    multisample(builder.multisample),
+    depthStencil(builder.depthStencil),
+    colorBlend(builder.colorBlend),
+    colorBlendAttachments(builder.colorBlendAttachments),
+    dynamicStates(builder.dynamicStates),
+    colorFormats(builder.colorFormats),
+    depthFormat(builder.depthFormat),
+    stencilFormat(builder.stencilFormat)
+{
+    // points into the builder after a build, the attachments are compared above
+    colorBlend.attachmentCount=0;
+    colorBlend.pAttachments=nullptr;
+
+    for (auto&& s : builder.shaders)
+    {
+        ShaderKey shader{ s.stage, s.module, s.pName ? s.pName : "", {}, {} };
+        if (s.pSpecializationInfo)
+        {
+            auto& info=*s.pSpecializationInfo;
+            shader.specializationEntries.assign(info.pMapEntries, info.pMapEntries+info.mapEntryCount);
+            auto data=static_cast<const byte*>(info.pData);
+            shader.specializationData.assign(data, data+info.dataSize);
+        }
+        shaders.push_back(std::move(shader));
+    }
+}
+
+PipelineRegistry::PipelineRegistry(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice) :
+    device(device),
+    defaultSampler(getDefaultSamplerInfo(physicalDevice))
+{
+}
+
+vk::Sampler PipelineRegistry::getSampler(const vk::SamplerCreateInfo& info)
+{
+    for (auto&& [key, sampler] : samplers)
+    {
+        if (key==info) return sampler;
+    }
+    return samplers.emplace_back(info, vk::raii::Sampler(device, info)).second;
+}
+
+vk::Sampler PipelineRegistry::getSampler()
+{
+    return getSampler(defaultSampler);
+}
+
+vk::ShaderModule PipelineRegistry::getShaderModule(const string& filename)
+{
+    auto finder=shaderModules.find(filename);
+    if (finder==shaderModules.end()) finder=shaderModules.emplace(filename, loadShaderModule(device, filename)).first;
+    return finder->second;
+}
+
+vk::DescriptorSetLayout PipelineRegistry::getDescriptorSetLayout(const DescriptorSetBuilder& builder)
+{
+    auto key=DescriptorSetLayoutKey{ builder.layoutFlags, builder.bindings };
+    for (auto&& [k, layout] : descriptorSetLayouts)
+    {
+        if (k==key) return layout;
+    }
+    return descriptorSetLayouts.emplace_back(std::move(key), builder.buildLayout(device)).second;
+}
+
+vk::PipelineLayout PipelineRegistry::getPipelineLayout(const PipelineLayoutBuilder& builder)
+{
+    auto key=PipelineLayoutKey{ builder.descriptorSets, builder.pushConstants };
+    for (auto&& [k, layout] : pipelineLayouts)
+    {
+        if (k==key) return layout;
+    }
+    return pipelineLayouts.emplace_back(std::move(key), builder.build(device)).second;
+}
+
+vk::Pipeline PipelineRegistry::getPipeline(PipelineBuilder& builder, vk::PipelineLayout layout)
+{
+    auto key=PipelineKey(builder, layout);
+    for (auto&& [k, pipeline] : pipelines)
+    {
+        if (k==key) return pipeline;
+    }
+    return pipelines.emplace_back(std::move(key), builder.build(device, layout)).second;
+}
@@ -0,0 +1,97 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#pragma once
+
+#include "common.h"
+#include "pipelinebuilder.h"
+
+//! @brief device wide cache of samplers, shader modules, layouts and pipelines.
+//! Asking twice for the same thing hands out the same object, so e.g. all
+//! particle systems share one pipeline. Everything lives as long as the device,
+//! the handles given out must not be destroyed by the caller.
+//! There are only a handful of objects of each kind, lookup is a linear search.
+class PipelineRegistry
+{
+public:
+    PipelineRegistry(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice);
+
+    PipelineRegistry(const PipelineRegistry& rhs) = delete;
+    PipelineRegistry& operator=(const PipelineRegistry& rhs) = delete;
+
+    vk::Sampler getSampler(const vk::SamplerCreateInfo& info);
+    //! linear filtering with mipmaps, repeating and anisotropic, used for all textures
+    vk::Sampler getSampler();
+
+    vk::ShaderModule getShaderModule(const string& filename);
+    vk::DescriptorSetLayout getDescriptorSetLayout(const DescriptorSetBuilder& builder);
+    vk::PipelineLayout getPipelineLayout(const PipelineLayoutBuilder& builder);
+    //! the shaders of the builder must come from getShaderModule to be recognized
+    vk::Pipeline getPipeline(PipelineBuilder& builder, vk::PipelineLayout layout);
+
+    //! number of pipelines actually compiled
+    inline size_t getPipelineCount() const noexcept { return pipelines.size(); }
+
+private:
+    struct ShaderKey
+    {
+        vk::ShaderStageFlagBits stage;
+        vk::ShaderModule module;
+        string entryPoint;
+        vector<vk::SpecializationMapEntry> specializationEntries;
+        vector<byte> specializationData;
+
+        bool operator==(const ShaderKey& rhs) const = default;
+    };
+
+    //! the builder state without the pointers that only live during PipelineBuilder::build
+    struct PipelineKey
+    {
+        vk::PipelineLayout layout;
+        vk::PipelineCreateFlags flags;
+        vector<ShaderKey> shaders;
+        vector<vk::VertexInputBindingDescription> vertexInputBindings;
+        vector<vk::VertexInputAttributeDescription> vertexInputAttributes;
+        vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
+        vk::PipelineTessellationStateCreateInfo tessellation;
+        vector<vk::Viewport> viewports;
+        vector<vk::Rect2D> scissors;
+        vk::PipelineRasterizationStateCreateInfo rasterization;
+        vk::PipelineMultisampleStateCreateInfo multisample;
+        vk::PipelineDepthStencilStateCreateInfo depthStencil;
+        vk::PipelineColorBlendStateCreateInfo colorBlend;
+        vector<vk::PipelineColorBlendAttachmentState> colorBlendAttachments;
+        vector<vk::DynamicState> dynamicStates;
+        vector<vk::Format> colorFormats;
+        vk::Format depthFormat;
+        vk::Format stencilFormat;
+
+        PipelineKey(const PipelineBuilder& builder, vk::PipelineLayout layout);
+        bool operator==(const PipelineKey& rhs) const = default;
+    };
+
+    struct DescriptorSetLayoutKey
+    {
+        vk::DescriptorSetLayoutCreateFlags flags;
+        vector<vk::DescriptorSetLayoutBinding> bindings;
+
+        bool operator==(const DescriptorSetLayoutKey& rhs) const = default;
+    };
+
+    struct PipelineLayoutKey
+    {
+        vector<vk::DescriptorSetLayout> descriptorSets;
+        vector<vk::PushConstantRange> pushConstants;
+
+        bool operator==(const PipelineLayoutKey& rhs) const = default;
+    };
+
+    const vk::raii::Device& device;
+    vk::SamplerCreateInfo defaultSampler;
+
+    vector<pair<vk::SamplerCreateInfo, vk::raii::Sampler>> samplers;
+    map<string, vk::raii::ShaderModule> shaderModules;
+    vector<pair<DescriptorSetLayoutKey, vk::raii::DescriptorSetLayout>> descriptorSetLayouts;
+    vector<pair<PipelineLayoutKey, vk::raii::PipelineLayout>> pipelineLayouts;
+    vector<pair<PipelineKey, vk::raii::Pipeline>> pipelines;
+};
@@ -6,28 +6,29 @@
 #include "pipelinebuilder.h"
 #include "vulkan.h"
 #include "vkutils.h"
+#include "profiler.h"
 
-PostProcess::PostProcess() :
+PostProcess::PostProcess(vk::ImageUsageFlags targetUsage) :
     pipelineLayout(nullptr),
-    pipeline(nullptr),
+    pipelines(),
     sampler(nullptr),
+    canBlit(false),
     descriptorLayout(nullptr),
-    descriptorPool(nullptr),
-    descriptors(nullptr),
-    currentDescriptor(0),
-    state(0.0f, 0.0f, 0.0f)
+    state(0.0f, 0.0f, 0.0f, 0.0f, glm::vec2(1.0f), glm::vec2(1.0f))
 {
+    auto& registry=vulkan.getRegistry();
     DescriptorSetBuilder descBuilder;
+    descBuilder.layoutFlags = vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR;
     descBuilder.bindings.emplace_back(0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment);
-    tie(descriptorLayout, descriptorPool, descriptors)=descBuilder.buildLayoutAndSets(vulkan.getDevice(), 2);
+    descriptorLayout=registry.getDescriptorSetLayout(descBuilder);
 
     PipelineLayoutBuilder layoutBuilder;
     layoutBuilder.descriptorSets.push_back(descriptorLayout);
     layoutBuilder.pushConstants.push_back(vk::PushConstantRange{.stageFlags=vk::ShaderStageFlagBits::eAllGraphics, 0, sizeof(PushData)});
-    pipelineLayout=layoutBuilder.build(vulkan.getDevice());
+    pipelineLayout=registry.getPipelineLayout(layoutBuilder);
 
     PipelineBuilder builder;
-    auto shaderModule=loadShaderModule(vulkan.getDevice(), "shaders/postprocess.spv");        
+    auto shaderModule=registry.getShaderModule("shaders/postprocess.spv");        
     builder.shaders.push_back({ .stage=vk::ShaderStageFlagBits::eVertex, .module=shaderModule, .pName="vertMain"});
     builder.inputAssembly.topology = vk::PrimitiveTopology::eTriangleStrip;
     builder.shaders.push_back({ .stage=vk::ShaderStageFlagBits::eFragment, .module=shaderModule, .pName="fragMain"});
@@ -35,9 +36,42 @@ PostProcess::PostProcess() :
     builder.addColorAttachment(
         vulkan.getSwapChainFormat().format
     );
-    pipeline = builder.build(vulkan.getDevice(),pipelineLayout);
 
-    sampler = createSampler(vulkan.getPhysicalDevice(), vulkan.getDevice());
+    array<vk::SpecializationMapEntry, 3> specializationEntries{{
+        { 0, 0*sizeof(vk::Bool32), sizeof(vk::Bool32) },
+        { 1, 1*sizeof(vk::Bool32), sizeof(vk::Bool32) },
+        { 2, 2*sizeof(vk::Bool32), sizeof(vk::Bool32) }
+    }};
+    for (uint32_t effects=0; effects<EffectCombinations; ++effects)
+    {
+        array<vk::Bool32, 3> enabled={
+            (effects & Chaos) ? vk::True : vk::False,
+            (effects & Confuse) ? vk::True : vk::False,
+            (effects & Shake) ? vk::True : vk::False
+        };
+        auto specialization=vk::SpecializationInfo{}
+            .setMapEntries(specializationEntries)
+            .setData<vk::Bool32>(enabled);
+        for (auto&& s : builder.shaders) s.pSpecializationInfo=&specialization;
+        pipelines.push_back(registry.getPipeline(builder, pipelineLayout));
+    }
+
+    sampler = registry.getSampler();
+
+    // without effects the scene is just blitted, if the format and the target allow it
+    auto features=vulkan.getPhysicalDevice().getFormatProperties(vulkan.getSwapChainFormat().format).optimalTilingFeatures;
+    canBlit=(features & vk::FormatFeatureFlagBits::eBlitSrc) && (features & vk::FormatFeatureFlagBits::eBlitDst) &&
+        (targetUsage & vk::ImageUsageFlagBits::eTransferDst);
+}
+
+uint32_t PostProcess::getActiveEffects() const noexcept
+{
+    return (state.chaos>0.0f ? Chaos : 0) | (state.confuse>0.0f ? Confuse : 0) | (state.shake>0.0f ? Shake : 0);
+}
+
+bool PostProcess::isPassNeeded() const noexcept
+{
+    return !canBlit || getActiveEffects()!=0;
 }
 
 void PostProcess::update(float dt)
@@ -47,31 +81,49 @@ void PostProcess::update(float dt)
     state.shake -= dt;
 }
 
-void PostProcess::draw(const vk::CommandBuffer& commandBuffer, const vk::ImageView image)
+void PostProcess::draw(const vk::CommandBuffer& buffer, const DeviceImage& source, const vk::Extent2D& sourceExtent)
 {
+    CountingCommandBuffer commandBuffer(buffer, Profiler::PostProcess);
+    auto imageExtent=source.getDescription().extent;
+    glm::vec2 size={ imageExtent.width, imageExtent.height };
+    glm::vec2 used={ sourceExtent.width, sourceExtent.height };
+    state.sourceScale=used/size;
+    state.sourceLimit=(used-0.5f)/size;
+
     auto imageInfo = vk::DescriptorImageInfo
     {
         .sampler = sampler,
-        .imageView = image,
+        .imageView = source,
         .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
     };
 
+    // the image is pushed into the command buffer, so there are no descriptor
+    // sets to update on the device while earlier frames are still in flight
     std::array descriptorWrites{
         vk::WriteDescriptorSet{
-            .dstSet=descriptors[currentDescriptor],
             .dstBinding=0,
             .descriptorCount=1,
             .descriptorType=vk::DescriptorType::eCombinedImageSampler,
             .pImageInfo=&imageInfo
         }
     };
-    vulkan.getDevice().updateDescriptorSets(descriptorWrites, {});
-    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
-    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, *descriptors[currentDescriptor], {});
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelines[getActiveEffects()]);
+    commandBuffer.pushDescriptorSetKHR(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, descriptorWrites, *vulkan.getDevice().getDispatcher());
 
     commandBuffer.pushConstants<PushData>(pipelineLayout, vk::ShaderStageFlagBits::eAllGraphics, 0, state);
 
     commandBuffer.draw(4,1,0,0);
+}
 
-    currentDescriptor = (currentDescriptor+1) % descriptors.size();
+void PostProcess::blit(const vk::CommandBuffer& commandBuffer, DeviceImage& source, const vk::Extent2D& sourceExtent, DeviceImage& target)
+{
+    auto srcExtent=sourceExtent;
+    auto dstExtent=target.getDescription().extent;
+    auto region=vk::ImageBlit{
+        .srcSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+        .srcOffsets = std::array<vk::Offset3D,2>{ vk::Offset3D{0, 0, 0}, vk::Offset3D{int32_t(srcExtent.width), int32_t(srcExtent.height), 1} },
+        .dstSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+        .dstOffsets = std::array<vk::Offset3D,2>{ vk::Offset3D{0, 0, 0}, vk::Offset3D{int32_t(dstExtent.width), int32_t(dstExtent.height), 1} }
+    };
+    commandBuffer.blitImage(source, vk::ImageLayout::eTransferSrcOptimal, target, vk::ImageLayout::eTransferDstOptimal, region, vk::Filter::eLinear);
 }
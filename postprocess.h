@@ -4,36 +4,59 @@
 #pragma once
 
 #include "common.h"
+#include "buffermanager.h"
 #include <glm/glm.hpp>
 
 class PostProcess
 {
 public:
-    PostProcess();
+    enum Effect
+    {
+        Chaos = 1,
+        Confuse = 2,
+        Shake = 4,
+
+        EffectCombinations = 8
+    };
+
+public:
+    //! targetUsage is the usage of the images drawn to, blitting needs eTransferDst
+    PostProcess(vk::ImageUsageFlags targetUsage);
 
     void update(float dt);
-    void draw(const vk::CommandBuffer& commandBuffer, const vk::ImageView image);
+
+    //! false if no effect is active and the scene can be blitted to the target as is
+    bool isPassNeeded() const noexcept;
+    //! both scale the top left sourceExtent pixels of source to the whole target,
+    //! the rest of source is never read (see RenderTarget::setRenderExtent).
+    //! The images must already be in the layouts for sampling and rendering, or
+    //! transfer source and destination for the blit (see FrameGraph)
+    void draw(const vk::CommandBuffer& commandBuffer, const DeviceImage& source, const vk::Extent2D& sourceExtent);
+    void blit(const vk::CommandBuffer& commandBuffer, DeviceImage& source, const vk::Extent2D& sourceExtent, DeviceImage& target);
 
     inline void shake(float length) { state.shake = length; }
     inline void confuse(float length) { state.confuse = length; }
     inline void chaos(float length) { state.chaos = length; }
 
 private:
-    vk::raii::PipelineLayout pipelineLayout;
-    vk::raii::Pipeline pipeline;
-    vk::raii::Sampler sampler;
+    vk::PipelineLayout pipelineLayout;      // shared through PipelineRegistry
+    vector<vk::Pipeline> pipelines;         // one variant per combination of active effects
+    vk::Sampler sampler;
+    bool canBlit;
 
-    vk::raii::DescriptorSetLayout descriptorLayout;
-    vk::raii::DescriptorPool descriptorPool;
-    vk::raii::DescriptorSets descriptors;
-    uint32_t currentDescriptor;
+    vk::DescriptorSetLayout descriptorLayout;   // push descriptor layout, no pool needed
 
     struct PushData
     {
         glm::f32 chaos;
         glm::f32 confuse;
         glm::f32 shake;
+        glm::f32 padding;
+        glm::vec2 sourceScale;  // of the texture coordinates to the used part of the source
+        glm::vec2 sourceLimit;  // last texture coordinate that doesn't filter in unused pixels
     };
 
     PushData state;
-};
\ No newline at end of file
+
+    uint32_t getActiveEffects() const noexcept;
+};
@@ -0,0 +1,311 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+
+#include "profiler.h"
+#include "vulkan.h"
+#include <fstream>
+#include <format>
+#include <atomic>
+
+Profiler profiler;  // the global profiler instance
+
+namespace
+{
+    uint32_t threadIndex()
+    {
+        static atomic<uint32_t> nextThread=0;
+        thread_local uint32_t index=nextThread++;
+        return index;
+    }
+
+    constexpr uint32_t GpuThread = numeric_limits<uint32_t>::max();
+    constexpr uint32_t NoZone = numeric_limits<uint32_t>::max();
+
+    constexpr const char* SubsystemNames[Profiler::SubsystemCount] = { "Sprites", "Particles", "Text", "PostProcess" };
+
+    // zone names are string literals, but escape them anyway
+    string jsonEscape(const char* text)
+    {
+        string result;
+        for (; *text; ++text)
+        {
+            if (*text=='"' || *text=='\\') result+='\\';
+            result+=*text;
+        }
+        return result;
+    }
+}
+
+Profiler::Profiler() :
+    start(Clock::now()),
+    frames(),
+    frameCounter(0),
+    queryPool(nullptr),
+    timestampPeriod(0.0),
+    timestampMask(0),
+    slots(),
+    currentSlot(0),
+    latestGpuFrame(0)
+{
+}
+
+void Profiler::initializeGpu(size_t framesInFlight)
+{
+    auto limits=vulkan.getPhysicalDevice().getProperties().limits;
+    auto validBits=vulkan.getPhysicalDevice().getQueueFamilyProperties()[vulkan.getGraphicsQueueIndex()].timestampValidBits;
+    if (!limits.timestampComputeAndGraphics || validBits==0)
+    {
+        cerr << "GPU timestamps are not supported, GPU profiling is disabled" << endl;
+        return;
+    }
+
+    timestampPeriod=limits.timestampPeriod;
+    timestampMask=validBits>=64 ? numeric_limits<uint64_t>::max() : (uint64_t(1)<<validBits)-1;
+    slots.resize(framesInFlight);
+    queryPool=vk::raii::QueryPool(vulkan.getDevice(), vk::QueryPoolCreateInfo{
+        .queryType = vk::QueryType::eTimestamp,
+        .queryCount = static_cast<uint32_t>(framesInFlight*MaxGpuZones*2)
+    });
+}
+
+void Profiler::cleanup()
+{
+    queryPool=nullptr;
+    slots.clear();
+}
+
+void Profiler::beginFrame()
+{
+    lock_guard guard(lock);
+    threadIndex();  // make sure the main thread is thread 0
+
+    // an aborted frame (e.g. swap chain reset) is simply overwritten
+    if (currentFrame().complete || frameCounter==0) ++frameCounter;
+
+    auto& frame=currentFrame();
+    frame.index=frameCounter;
+    frame.begin=now();
+    frame.submit=frame.begin;
+    frame.end=frame.begin;
+    frame.complete=false;
+    frame.cpu.clear();
+    frame.gpu.clear();
+    frame.draws={};
+}
+
+void Profiler::submitFrame()
+{
+    lock_guard guard(lock);
+    currentFrame().submit=now();
+}
+
+void Profiler::endFrame()
+{
+    lock_guard guard(lock);
+    auto& frame=currentFrame();
+    frame.end=now();
+    frame.complete=true;
+}
+
+void Profiler::beginGpuFrame(const vk::CommandBuffer& commandBuffer, size_t frameSlot)
+{
+    if (!*queryPool) return;
+
+    lock_guard guard(lock);
+    // Vulkan::waitForFrame has seen the frame timeline pass the last frame of this slot,
+    // so its old queries are done
+    collectGpuResults(frameSlot);
+
+    currentSlot=frameSlot;
+    auto& slot=slots[currentSlot];
+    slot.frame=frameCounter;
+    slot.names.clear();
+    commandBuffer.resetQueryPool(*queryPool, static_cast<uint32_t>(currentSlot*MaxGpuZones*2), MaxGpuZones*2);
+}
+
+uint32_t Profiler::beginGpuZone(const vk::CommandBuffer& commandBuffer, const char* name)
+{
+    if (!*queryPool) return NoZone;
+
+    lock_guard guard(lock);
+    auto& slot=slots[currentSlot];
+    if (slot.frame!=frameCounter || slot.names.size()>=MaxGpuZones) return NoZone;
+
+    auto zone=static_cast<uint32_t>(slot.names.size());
+    slot.names.push_back(name);
+    commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, *queryPool, static_cast<uint32_t>((currentSlot*MaxGpuZones+zone)*2));
+    return zone;
+}
+
+void Profiler::endGpuZone(const vk::CommandBuffer& commandBuffer, uint32_t zone)
+{
+    if (zone==NoZone) return;
+    commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe, *queryPool, static_cast<uint32_t>((currentSlot*MaxGpuZones+zone)*2+1));
+}
+
+void Profiler::collectGpuResults(size_t slotIndex)
+{
+    auto& slot=slots[slotIndex];
+    if (slot.names.empty()) return;
+
+    auto count=static_cast<uint32_t>(slot.names.size()*2);
+    auto [result, timestamps]=queryPool.getResults<uint64_t>(
+        static_cast<uint32_t>(slotIndex*MaxGpuZones*2),
+        count,
+        count*sizeof(uint64_t),
+        sizeof(uint64_t),
+        vk::QueryResultFlagBits::e64
+    );
+    if (result!=vk::Result::eSuccess) return;
+
+    // the ring buffer might have moved past this frame already
+    auto& frame=frames[slot.frame%MaxFrames];
+    if (frame.index!=slot.frame) return;
+
+    uint64_t base=timestamps[0]&timestampMask;
+    for (size_t i=0; i<slot.names.size(); ++i)
+    {
+        auto toMicro=[this,base](uint64_t ts) { return double(((ts&timestampMask)-base)&timestampMask)*timestampPeriod/1000.0; };
+        frame.gpu.emplace_back(slot.names[i], GpuThread, toMicro(timestamps[i*2]), toMicro(timestamps[i*2+1]));
+    }
+    slot.names.clear();
+    latestGpuFrame=max(latestGpuFrame, slot.frame);
+}
+
+void Profiler::addCpuZone(const char* name, double begin, double end)
+{
+    auto thread=threadIndex();
+    lock_guard guard(lock);
+    currentFrame().cpu.emplace_back(name, thread, begin, end);
+}
+
+void Profiler::addDrawStats(Subsystem subsystem, const DrawStats& stats)
+{
+    lock_guard guard(lock);
+    currentFrame().draws[subsystem]+=stats;
+}
+
+void Profiler::writeChromeTrace(const filesystem::path& file, size_t frameCount) const
+{
+    lock_guard guard(lock);
+
+    auto out=ofstream(file);
+    if (!out) throw runtime_error("Failed to open trace file '"+file.string()+"'");
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Main\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GpuThread << ",\"args\":{\"name\":\"GPU\"}}";
+
+    auto writeZone=[&out](const char* name, uint32_t thread, double begin, double end) {
+        out << ",\n{\"name\":\"" << jsonEscape(name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread
+            << ",\"ts\":" << fixed << begin << ",\"dur\":" << (end-begin) << "}";
+    };
+
+    frameCount=min<size_t>({frameCount, MaxFrames, frameCounter});
+    for (auto index=frameCounter-frameCount+1; index<=frameCounter; ++index)
+    {
+        const auto& frame=frames[index%MaxFrames];
+        if (frame.index!=index || !frame.complete) continue;
+
+        writeZone("Frame", 0, frame.begin, frame.end);
+        for (auto&& z : frame.cpu) writeZone(z.name, z.thread, z.begin, z.end);
+        // without calibrated timestamps we line the GPU work up with the submit
+        for (auto&& z : frame.gpu) writeZone(z.name, GpuThread, frame.submit+z.begin, frame.submit+z.end);
+
+        for (size_t s=0; s<SubsystemCount; ++s)
+        {
+            const auto& d=frame.draws[s];
+            out << ",\n{\"name\":\"" << SubsystemNames[s] << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << fixed << frame.begin
+                << ",\"args\":{\"draws\":" << d.draws << ",\"pipelines\":" << d.pipelineBinds
+                << ",\"descriptors\":" << d.descriptorBinds << ",\"pushBytes\":" << d.pushConstantBytes << "}}";
+        }
+    }
+    out << "\n]}\n";
+}
+
+void Profiler::writeSummary(ostream& out, size_t frameCount) const
+{
+    lock_guard guard(lock);
+
+    double frameTime=0.0;
+    size_t samples=0;
+    array<DrawStats, SubsystemCount> draws={};
+    frameCount=min<size_t>({frameCount, MaxFrames, frameCounter});
+    for (auto index=frameCounter-frameCount+1; index<=frameCounter; ++index)
+    {
+        const auto& frame=frames[index%MaxFrames];
+        if (frame.index!=index || !frame.complete) continue;
+
+        frameTime+=frame.end-frame.begin;
+        for (size_t s=0; s<SubsystemCount; ++s) draws[s]+=frame.draws[s];
+        ++samples;
+    }
+    if (samples==0) return;
+
+    out << format("frames: {}  average frame: {:.3f} ms\n", samples, frameTime/double(samples)/1000.0);
+    out << "subsystem      draws/frame  pipelines/frame  descriptors/frame  push bytes/frame\n";
+    for (size_t s=0; s<SubsystemCount; ++s)
+    {
+        auto avg=[samples](uint32_t v) { return double(v)/double(samples); };
+        out << format("{:<14} {:>11.1f} {:>16.1f} {:>18.1f} {:>17.1f}\n",
+            SubsystemNames[s], avg(draws[s].draws), avg(draws[s].pipelineBinds), avg(draws[s].descriptorBinds), avg(draws[s].pushConstantBytes));
+    }
+}
+
+vector<string> Profiler::getHudLines() const
+{
+    lock_guard guard(lock);
+
+    double frameTime=0.0, cpuTime=0.0, gpuTime=0.0;
+    size_t frameSamples=0, gpuSamples=0;
+    DrawStats draws;
+    for (auto index=frameCounter; index>0 && frameCounter-index<min(HudFrames, MaxFrames); --index)
+    {
+        const auto& frame=frames[index%MaxFrames];
+        if (frame.index!=index || !frame.complete) continue;
+
+        // waiting for the swap chain is idle time, not work
+        double wait=0.0;
+        for (auto&& z : frame.cpu) if (string_view(z.name)=="SwapChain::waitForNextFrame") wait+=z.end-z.begin;
+
+        frameTime+=frame.end-frame.begin;
+        cpuTime+=frame.end-frame.begin-wait;
+        for (auto&& d : frame.draws) draws+=d;
+        ++frameSamples;
+
+        if (!frame.gpu.empty())
+        {
+            double first=frame.gpu.front().begin, last=frame.gpu.front().end;
+            for (auto&& z : frame.gpu)
+            {
+                first=min(first, z.begin);
+                last=max(last, z.end);
+            }
+            gpuTime+=last-first;
+            ++gpuSamples;
+        }
+    }
+    if (frameSamples==0) return {};
+
+    frameTime/=double(frameSamples);
+    vector<string> lines;
+    lines.push_back(format("FPS {:.0f}", frameTime>0.0 ? 1000000.0/frameTime : 0.0));
+    lines.push_back(format("CPU {:.2f}", cpuTime/double(frameSamples)/1000.0));
+    if (gpuSamples>0) lines.push_back(format("GPU {:.2f}", gpuTime/double(gpuSamples)/1000.0));
+    lines.push_back(format("DRAW {}", draws.draws/frameSamples));
+    lines.push_back(format("BIND {}", (draws.pipelineBinds+draws.descriptorBinds)/frameSamples));
+    return lines;
+}
+
+optional<Profiler::GpuSample> Profiler::getLatestGpuZoneTime(string_view name) const
+{
+    lock_guard guard(lock);
+
+    // no falling back to older frames, they have been handed out before
+    const auto& frame=frames[latestGpuFrame%MaxFrames];
+    if (latestGpuFrame==0 || frame.index!=latestGpuFrame) return nullopt;
+    auto zone=ranges::find_if(frame.gpu, [name](const Zone& z) { return name==z.name; });
+    if (zone==frame.gpu.end()) return nullopt;
+    return GpuSample{ latestGpuFrame, zone->end-zone->begin };
+}
@@ -0,0 +1,252 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#pragma once
+
+#include "common.h"
+#include <chrono>
+#include <mutex>
+
+//! @brief collects CPU zones and GPU timestamps per frame.
+//! The last MaxFrames frames are kept in a ring buffer and can be written
+//! out as a Chrome trace (load it in chrome://tracing or ui.perfetto.dev).
+//! GPU results arrive once the frame timeline has passed the frame (see
+//! Vulkan::waitForFrame), i.e. when the same frame-in-flight slot is started again.
+class Profiler
+{
+public:
+    static constexpr size_t MaxFrames = 240;
+    static constexpr uint32_t MaxGpuZones = 16;
+    static constexpr size_t HudFrames = 60;
+
+    using Clock = chrono::steady_clock;
+
+    enum Subsystem
+    {
+        Sprites,
+        Particles,
+        Text,
+        PostProcess,
+
+        SubsystemCount
+    };
+
+    struct DrawStats
+    {
+        uint32_t draws = 0;
+        uint32_t pipelineBinds = 0;
+        uint32_t descriptorBinds = 0;
+        uint32_t pushConstantBytes = 0;
+
+        inline DrawStats& operator+=(const DrawStats& rhs) noexcept
+        {
+            draws+=rhs.draws;
+            pipelineBinds+=rhs.pipelineBinds;
+            descriptorBinds+=rhs.descriptorBinds;
+            pushConstantBytes+=rhs.pushConstantBytes;
+            return *this;
+        }
+    };
+
+    struct Zone
+    {
+        const char* name;
+        uint32_t thread;
+        double begin;   // CPU zones: microseconds since profiler start
+        double end;     // GPU zones: microseconds since the first timestamp of the frame
+    };
+
+    struct Frame
+    {
+        uint64_t index = 0;
+        double begin = 0.0;
+        double submit = 0.0;
+        double end = 0.0;
+        bool complete = false;
+        vector<Zone> cpu;
+        vector<Zone> gpu;
+        array<DrawStats, SubsystemCount> draws;
+    };
+
+    class CpuZone
+    {
+    public:
+        inline CpuZone(const char* name);
+        inline ~CpuZone();
+
+    private:
+        const char* name;
+        double begin;
+    };
+
+    class GpuZone
+    {
+    public:
+        inline GpuZone(const vk::CommandBuffer& commandBuffer, const char* name);
+        inline ~GpuZone();
+
+    private:
+        vk::CommandBuffer commandBuffer;
+        uint32_t zone;
+    };
+
+public:
+    Profiler();
+
+    void initializeGpu(size_t framesInFlight);
+    void cleanup();
+
+    // CPU frame boundaries
+    void beginFrame();
+    void submitFrame();
+    void endFrame();
+
+    // GPU timestamps, frameSlot is the frame-in-flight index of the command buffer
+    void beginGpuFrame(const vk::CommandBuffer& commandBuffer, size_t frameSlot);
+    uint32_t beginGpuZone(const vk::CommandBuffer& commandBuffer, const char* name);
+    void endGpuZone(const vk::CommandBuffer& commandBuffer, uint32_t zone);
+
+    void addCpuZone(const char* name, double begin, double end);
+    void addDrawStats(Subsystem subsystem, const DrawStats& stats);
+    inline double now() const noexcept { return chrono::duration<double, micro>(Clock::now()-start).count(); }
+
+    void writeChromeTrace(const filesystem::path& file, size_t frameCount=MaxFrames) const;
+    void writeSummary(ostream& out, size_t frameCount=MaxFrames) const;
+    vector<string> getHudLines() const;
+    struct GpuSample
+    {
+        uint64_t frame;
+        double time;    // microseconds
+    };
+    //! GPU time of a zone in the frame whose results came in last. That stays the same
+    //! frame until newer results arrive, so compare frame to use each sample once.
+    optional<GpuSample> getLatestGpuZoneTime(string_view name) const;
+
+private:
+    struct GpuSlot
+    {
+        uint64_t frame = numeric_limits<uint64_t>::max();
+        vector<const char*> names;
+    };
+
+    Clock::time_point start;
+    mutable mutex lock;
+    array<Frame, MaxFrames> frames;
+    uint64_t frameCounter;
+
+    vk::raii::QueryPool queryPool;
+    double timestampPeriod;   // nanoseconds per tick
+    uint64_t timestampMask;
+    vector<GpuSlot> slots;
+    size_t currentSlot;
+    uint64_t latestGpuFrame;    // the newest frame with GPU results, 0 for none
+
+    inline Frame& currentFrame() noexcept { return frames[frameCounter%MaxFrames]; }
+    void collectGpuResults(size_t slot);
+};
+
+extern Profiler profiler;
+
+//! @brief forwards the command buffer calls used by the renderers and counts
+//! them. The counts are handed to the profiler once, when the wrapper dies.
+class CountingCommandBuffer
+{
+public:
+    inline CountingCommandBuffer(const vk::CommandBuffer& buffer, Profiler::Subsystem subsystem) :
+        buffer(buffer),
+        subsystem(subsystem),
+        stats()
+    {}
+
+    inline ~CountingCommandBuffer()
+    {
+        profiler.addDrawStats(subsystem, stats);
+    }
+
+    CountingCommandBuffer(const CountingCommandBuffer& rhs) = delete;
+    CountingCommandBuffer& operator=(const CountingCommandBuffer& rhs) = delete;
+
+    inline operator const vk::CommandBuffer&() const noexcept { return buffer; }
+
+    inline void bindPipeline(vk::PipelineBindPoint bindPoint, vk::Pipeline pipeline)
+    {
+        buffer.bindPipeline(bindPoint, pipeline);
+        ++stats.pipelineBinds;
+    }
+
+    inline void bindDescriptorSets(
+        vk::PipelineBindPoint bindPoint,
+        vk::PipelineLayout layout,
+        uint32_t firstSet,
+        vk::ArrayProxy<const vk::DescriptorSet> const& sets,
+        vk::ArrayProxy<const uint32_t> const& dynamicOffsets={}
+    )
+    {
+        buffer.bindDescriptorSets(bindPoint, layout, firstSet, sets, dynamicOffsets);
+        stats.descriptorBinds+=sets.size();
+    }
+
+    // push descriptors come from an extension, so the caller has to hand in the device dispatcher
+    template<typename Dispatch>
+    inline void pushDescriptorSetKHR(
+        vk::PipelineBindPoint bindPoint,
+        vk::PipelineLayout layout,
+        uint32_t set,
+        vk::ArrayProxy<const vk::WriteDescriptorSet> const& writes,
+        const Dispatch& dispatch
+    )
+    {
+        buffer.pushDescriptorSetKHR(bindPoint, layout, set, writes, dispatch);
+        ++stats.descriptorBinds;
+    }
+
+    template<typename T>
+    inline void pushConstants(vk::PipelineLayout layout, vk::ShaderStageFlags stages, uint32_t offset, const T& value)
+    {
+        buffer.pushConstants<T>(layout, stages, offset, value);
+        stats.pushConstantBytes+=sizeof(T);
+    }
+
+    inline void bindVertexBuffers(uint32_t firstBinding, vk::ArrayProxy<const vk::Buffer> const& buffers, vk::ArrayProxy<const vk::DeviceSize> const& offsets)
+    {
+        buffer.bindVertexBuffers(firstBinding, buffers, offsets);
+    }
+
+    inline void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+    {
+        buffer.draw(vertexCount, instanceCount, firstVertex, firstInstance);
+        ++stats.draws;
+    }
+
+private:
+    const vk::CommandBuffer& buffer;
+    Profiler::Subsystem subsystem;
+    Profiler::DrawStats stats;
+};
+
+#define PROFILE_CONCAT_IMPL(a,b) a##b
+#define PROFILE_CONCAT(a,b) PROFILE_CONCAT_IMPL(a,b)
+#define PROFILE_ZONE(name) Profiler::CpuZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_GPU_ZONE(commandBuffer, name) Profiler::GpuZone PROFILE_CONCAT(profileGpuZone, __LINE__)(commandBuffer, name)
+
+inline Profiler::CpuZone::CpuZone(const char* name) :
+    name(name),
+    begin(profiler.now())
+{
+}
+
+inline Profiler::CpuZone::~CpuZone()
+{
+    profiler.addCpuZone(name, begin, profiler.now());
+}
+
+inline Profiler::GpuZone::GpuZone(const vk::CommandBuffer& commandBuffer, const char* name) :
+    commandBuffer(commandBuffer),
+    zone(profiler.beginGpuZone(commandBuffer, name))
+{
+}
+
+inline Profiler::GpuZone::~GpuZone()
+{
+    profiler.endGpuZone(commandBuffer, zone);
+}
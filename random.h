@@ -0,0 +1,56 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#pragma once
+
+#include "common.h"
+#include <glm/glm.hpp>
+
+//! @brief seedable PCG32 random number generator.
+//! The whole state is two integers, so a generator can be copied, stored
+//! and restored to reproduce exactly the same sequence again. Different
+//! streams with the same seed give independent sequences.
+class Random
+{
+public:
+    explicit Random(uint64_t seed=0, uint64_t stream=0) noexcept
+    {
+        reseed(seed, stream);
+    }
+
+    inline void reseed(uint64_t seed, uint64_t stream=0) noexcept
+    {
+        state=0;
+        increment=(stream<<1u) | 1u;
+        next();
+        state+=seed;
+        next();
+    }
+
+    inline uint32_t next() noexcept
+    {
+        uint64_t old=state;
+        state=old*6364136223846793005ULL+increment;
+        uint32_t xorshifted=static_cast<uint32_t>(((old>>18u)^old)>>27u);
+        uint32_t rot=static_cast<uint32_t>(old>>59u);
+        return (xorshifted>>rot) | (xorshifted<<((-rot)&31));
+    }
+
+    //! uniform in [0,1)
+    inline float nextFloat() noexcept { return static_cast<float>(next()>>8)*(1.0f/16777216.0f); }
+
+    //! uniform in [0,count)
+    inline uint32_t below(uint32_t count) noexcept { return static_cast<uint32_t>((uint64_t(next())*count)>>32); }
+
+    inline float range(float min, float max) noexcept { return min+(max-min)*nextFloat(); }
+    inline glm::vec2 range(const glm::vec2& min, const glm::vec2& max) noexcept
+    {
+        float x=range(min.x, max.x);    // keep the evaluation order fixed
+        float y=range(min.y, max.y);
+        return { x, y };
+    }
+
+private:
+    uint64_t state;
+    uint64_t increment;
+};
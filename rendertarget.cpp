@@ -19,9 +19,11 @@ void RenderTarget::createImages(
 )
 {
     this->description=description,
+    this->renderExtent=description.extent;
     this->usage=usage;
 
-    vulkan.getDevice().waitIdle();
+    // frames in flight may still render into the old images
+    if (!images.empty()) vulkan.retire(std::move(images));
     images.clear();
     while (imageCount--)
     {
@@ -39,7 +41,7 @@ void RenderTarget::beginRenderTo(const vk::CommandBuffer& commandBuffer, const v
 {
     current->discardAndTransition(commandBuffer, vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentWrite, vk::ImageLayout::eColorAttachmentOptimal);
     
-    auto renderArea=vk::Rect2D(vk::Offset2D(0, 0), description.extent);
+    auto renderArea=vk::Rect2D(vk::Offset2D(0, 0), renderExtent);
     auto attachmentInfo = vk::RenderingAttachmentInfo{
         .imageView = *current,
         .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
@@ -56,10 +58,16 @@ void RenderTarget::beginRenderTo(const vk::CommandBuffer& commandBuffer, const v
     };
     
     commandBuffer.beginRendering(renderingInfo);
-    commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(description.extent.width), static_cast<float>(description.extent.height), 0.0f, 1.0f));
+    commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height), 0.0f, 1.0f));
     commandBuffer.setScissor(0, renderArea);
 }
 
+void RenderTarget::setRenderExtent(const vk::Extent2D& extent)
+{
+    renderExtent.width=clamp(extent.width, 1u, description.extent.width);
+    renderExtent.height=clamp(extent.height, 1u, description.extent.height);
+}
+
 void RenderTarget::endRenderTo(const vk::CommandBuffer& commandBuffer)
 {
     commandBuffer.endRendering();
@@ -74,6 +82,7 @@ void RenderTarget::cycle()
 
 MultisampleRenderTarget::MultisampleRenderTarget() :
     RenderTarget(),
+    samples(vk::SampleCountFlagBits::e1),
     msImages()
 {
 }
@@ -88,7 +97,9 @@ void MultisampleRenderTarget::createImages(
     RenderTarget::createImages(description, usage, imageCount);
 
     this->samples=samples;
+    if (!msImages.empty()) vulkan.retire(std::move(msImages));
     msImages.clear();
+    if (samples==vk::SampleCountFlagBits::e1) return;     // rendered straight into the images
     for (auto&& img : images)
     {
         msImages.push_back(vulkan.getBufferManager().createImage(
@@ -101,12 +112,18 @@ void MultisampleRenderTarget::createImages(
 
 void MultisampleRenderTarget::beginRenderTo(const vk::CommandBuffer& commandBuffer, const vk::ClearValue& clear)
 {
+    if (msImages.empty())
+    {
+        RenderTarget::beginRenderTo(commandBuffer, clear);
+        return;
+    }
+
     auto curMs=msImages.begin() + (current-images.begin());
 
     current->discardAndTransition(commandBuffer, vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentWrite, vk::ImageLayout::eColorAttachmentOptimal);
     curMs->discardAndTransition(commandBuffer, vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentWrite, vk::ImageLayout::eColorAttachmentOptimal);
     
-    auto renderArea=vk::Rect2D(vk::Offset2D(0, 0), description.extent);
+    auto renderArea=vk::Rect2D(vk::Offset2D(0, 0), renderExtent);
     auto attachmentInfo = vk::RenderingAttachmentInfo{
         .imageView = *curMs,
         .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
@@ -126,6 +143,6 @@ void MultisampleRenderTarget::beginRenderTo(const vk::CommandBuffer& commandBuff
     };
     
     commandBuffer.beginRendering(renderingInfo);
-    commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(description.extent.width), static_cast<float>(description.extent.height), 0.0f, 1.0f));
+    commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height), 0.0f, 1.0f));
     commandBuffer.setScissor(0, renderArea);
 }
@@ -16,6 +16,13 @@ public:
     void endRenderTo(const vk::CommandBuffer& commandBuffer);
 
     inline const auto& getDescription() const noexcept { return description; }
+    inline vk::ImageUsageFlags getUsage() const noexcept { return usage; }
+    inline DeviceImage& getCurrent() const { return *current; }
+
+    //! rendering only touches this much of the images, starting at the top left corner.
+    //! The whole image after createImages, limited to the image size.
+    void setRenderExtent(const vk::Extent2D& extent);
+    inline const vk::Extent2D& getRenderExtent() const noexcept { return renderExtent; }
 
 protected:
     void createImages(
@@ -27,6 +34,7 @@ protected:
     void cycle();
 
     ImageDescription description;
+    vk::Extent2D renderExtent;
     vk::ImageUsageFlags usage;
     vector<DeviceImage> images;
     vector<DeviceImage>::iterator current;
@@ -37,8 +45,11 @@ class MultisampleRenderTarget : public RenderTarget
 public:
     MultisampleRenderTarget();
 
+    //! with a single sample this renders like a plain RenderTarget
     void beginRenderTo(const vk::CommandBuffer& commandBuffer, const vk::ClearValue& clear);
 
+    inline vk::SampleCountFlagBits getSamples() const noexcept { return samples; }
+
 protected:
     void createImages(
         const ImageDescription& description,
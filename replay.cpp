@@ -0,0 +1,105 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+
+#include "replay.h"
+#include <fstream>
+
+namespace
+{
+    constexpr array<char,4> Magic = { 'B', 'O', 'R', 'P' };
+    constexpr uint32_t Version = 1;
+
+    struct Header
+    {
+        array<char,4> magic;
+        uint32_t version;
+        uint64_t seed;
+        uint64_t tickCount;
+        uint64_t runCount;
+    };
+
+    struct InputRun
+    {
+        Replay::Input input;
+        uint16_t reserved;
+        uint32_t length;
+    };
+
+    template<typename T>
+    void writeRaw(ostream& out, const T* data, size_t count)
+    {
+        out.write(reinterpret_cast<const char*>(data), static_cast<streamsize>(sizeof(T)*count));
+    }
+
+    template<typename T>
+    void readRaw(istream& in, T* data, size_t count)
+    {
+        in.read(reinterpret_cast<char*>(data), static_cast<streamsize>(sizeof(T)*count));
+        if (!in) throw runtime_error("Replay file is truncated");
+    }
+}
+
+Replay::Replay(uint64_t seed) :
+    seed(seed),
+    ticks()
+{
+}
+
+Replay Replay::load(const filesystem::path& file)
+{
+    auto in=ifstream(file, ios::binary);
+    if (!in) throw runtime_error("Failed to open replay '"+file.string()+"'");
+
+    Header header;
+    readRaw(in, &header, 1);
+    if (header.magic!=Magic) throw runtime_error("'"+file.string()+"' is not a replay file");
+    if (header.version!=Version) throw runtime_error("Unsupported replay version "+to_string(header.version));
+
+    // the counts come from the file, check them against its size before allocating
+    auto payload=filesystem::file_size(file)-sizeof(Header);
+    if (header.tickCount>payload/sizeof(float) || header.runCount>(payload-header.tickCount*sizeof(float))/sizeof(InputRun))
+    {
+        throw runtime_error("Replay '"+file.string()+"' is truncated or corrupt");
+    }
+
+    vector<float> dts(header.tickCount);
+    vector<InputRun> runs(header.runCount);
+    readRaw(in, dts.data(), dts.size());
+    readRaw(in, runs.data(), runs.size());
+
+    Replay replay(header.seed);
+    replay.ticks.reserve(dts.size());
+    auto dt=dts.begin();
+    for (auto&& run : runs)
+    {
+        for (uint32_t i=0; i<run.length; ++i)
+        {
+            if (dt==dts.end()) throw runtime_error("Replay input runs exceed tick count");
+            replay.ticks.emplace_back(*dt++, run.input);
+        }
+    }
+    if (dt!=dts.end()) throw runtime_error("Replay input runs do not cover all ticks");
+    return replay;
+}
+
+void Replay::save(const filesystem::path& file) const
+{
+    vector<float> dts;
+    vector<InputRun> runs;
+    dts.reserve(ticks.size());
+    for (auto&& t : ticks)
+    {
+        dts.push_back(t.dt);
+        if (runs.empty() || runs.back().input!=t.input) runs.push_back({ t.input, 0, 1 });
+        else ++runs.back().length;
+    }
+
+    auto out=ofstream(file, ios::binary | ios::trunc);
+    if (!out) throw runtime_error("Failed to write replay '"+file.string()+"'");
+
+    Header header{ Magic, Version, seed, dts.size(), runs.size() };
+    writeRaw(out, &header, 1);
+    writeRaw(out, dts.data(), dts.size());
+    writeRaw(out, runs.data(), runs.size());
+}
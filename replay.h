@@ -0,0 +1,37 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#pragma once
+
+#include "common.h"
+
+//! @brief recorded game session: the seed plus the input and time step of every tick.
+//! On disk the time steps are stored as raw floats (so playback is bit exact)
+//! and the input is run-length encoded, since it rarely changes between ticks.
+class Replay
+{
+public:
+    using Input = uint16_t;
+
+    struct Tick
+    {
+        float dt;
+        Input input;
+    };
+
+public:
+    explicit Replay(uint64_t seed=0);
+
+    static Replay load(const filesystem::path& file);
+    void save(const filesystem::path& file) const;
+
+    inline void record(float dt, Input input) { ticks.emplace_back(dt, input); }
+
+    inline uint64_t getSeed() const noexcept { return seed; }
+    inline const vector<Tick>& getTicks() const noexcept { return ticks; }
+    inline float getDuration() const noexcept { return accumulate(ticks.begin(), ticks.end(), 0.0f, [](float sum, const Tick& t) { return sum+t.dt; }); }
+
+private:
+    uint64_t seed;
+    vector<Tick> ticks;
+};
@@ -0,0 +1,56 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+
+#include "resolutioncontroller.h"
+#include <cmath>
+
+ResolutionController::ResolutionController(double target, float minScale, float maxScale) :
+    target(target),
+    minScale(minScale),
+    maxScale(maxScale),
+    scale(maxScale),
+    lastFrame(0),
+    timeSum(0.0),
+    frames(0),
+    settle(0)
+{
+}
+
+bool ResolutionController::update(uint64_t frame, double gpuTime)
+{
+    // a frame measured twice would count twice in the average and the settle window
+    if (frame<=lastFrame) return false;
+    lastFrame=frame;
+
+    if (settle>0)
+    {
+        --settle;
+        return false;
+    }
+
+    timeSum+=gpuTime;
+    if (++frames<Interval) return false;
+
+    auto ratio=timeSum/double(frames)/target;
+    timeSum=0.0;
+    frames=0;
+    if (abs(ratio-1.0)<=Hysteresis) return false;
+
+    // the GPU time grows with the pixel count, i.e. with the square of the scale
+    auto wanted=scale*float(1.0/sqrt(ratio));
+    wanted=clamp(wanted, scale-MaxStepDown, scale+MaxStepUp);
+    wanted=clamp(wanted, minScale, maxScale);
+    if (abs(wanted-scale)<MinStep) return false;
+
+    scale=wanted;
+    settle=SettleFrames;
+    return true;
+}
+
+void ResolutionController::setBounds(float minScale, float maxScale)
+{
+    this->minScale=minScale;
+    this->maxScale=maxScale;
+    scale=clamp(scale, minScale, maxScale);
+}
@@ -0,0 +1,44 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+#pragma once
+
+#include "common.h"
+
+//! @brief picks the render scale of the scene to hold its GPU time near a target.
+//! Fed with one measurement per frame, it decides every Interval frames. Nothing
+//! changes while the average is within Hysteresis of the target. Going down may
+//! take big steps so an explosion costs resolution instead of frames, going up
+//! is slow so the scale doesn't bounce back and forth.
+class ResolutionController
+{
+public:
+    static constexpr size_t Interval = 8;
+    static constexpr size_t SettleFrames = 3;       // measurements of frames in flight during a change are dropped
+    static constexpr float Hysteresis = 0.1f;
+    static constexpr float MaxStepDown = 0.25f;
+    static constexpr float MaxStepUp = 0.05f;
+    static constexpr float MinStep = 0.01f;
+
+public:
+    //! target in microseconds, starts at the maximum scale
+    ResolutionController(double target, float minScale, float maxScale);
+
+    //! gpuTime of a frame in microseconds, true if the scale has changed.
+    //! Frames that are not newer than the last one are ignored.
+    bool update(uint64_t frame, double gpuTime);
+    void setBounds(float minScale, float maxScale);
+
+    inline float getScale() const noexcept { return scale; }
+
+private:
+    double target;
+    float minScale;
+    float maxScale;
+    float scale;
+
+    uint64_t lastFrame;
+    double timeSum;
+    size_t frames;
+    size_t settle;
+};
@@ -6,6 +6,19 @@
 #include "pipelinebuilder.h"
 #include "vulkan.h"
 #include "vkutils.h"
+#include "profiler.h"
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    DescriptorSetBuilder getDescriptorBuilder()
+    {
+        DescriptorSetBuilder builder;
+        builder.bindings.emplace_back(0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment);
+        return builder;
+    }
+}
 
 SpriteManager::SpriteManager(
     size_t layers,
@@ -14,6 +27,7 @@ SpriteManager::SpriteManager(
 ) :
     pipelineLayout(nullptr),
     pipeline(nullptr),
+    samples(vk::SampleCountFlagBits::e4),
     descriptorLayout(nullptr),
     descriptorPool(nullptr),
     descriptors(nullptr),
@@ -28,22 +42,32 @@ SpriteManager::SpriteManager(
     if (maxTextures>256) throw runtime_error("SpriteManager cannot handle more than 256 textures.");
     iota(freeTextureIds.rbegin(), freeTextureIds.rend(), 0);
 
-    DescriptorSetBuilder descBuilder;
-    descBuilder.bindings.emplace_back(0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment);
-    tie(descriptorLayout, descriptorPool, descriptors)=descBuilder.buildLayoutAndSets(vulkan.getDevice(), 256);
+    auto& registry=vulkan.getRegistry();
+    auto descBuilder=getDescriptorBuilder();
+    descriptorLayout=registry.getDescriptorSetLayout(descBuilder);
+    tie(descriptorPool, descriptors)=descBuilder.buildPoolAndSets(vulkan.getDevice(), descriptorLayout, 256);
 
     PipelineLayoutBuilder layoutBuilder;
     layoutBuilder.descriptorSets.push_back(descriptorLayout);
-    layoutBuilder.pushConstants.emplace_back(vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::mat4)+sizeof(SpritePushData));
-    pipelineLayout=layoutBuilder.build(vulkan.getDevice());
+    layoutBuilder.pushConstants.emplace_back(vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::mat4)+sizeof(SpriteDrawData));
+    pipelineLayout=registry.getPipelineLayout(layoutBuilder);
+
+    setSamples(vk::SampleCountFlagBits::e4);
+}
+
+void SpriteManager::setSamples(vk::SampleCountFlagBits samples)
+{
+    this->samples=samples;
+    for (auto& l : layers) l.cacheValid=false;
 
+    auto& registry=vulkan.getRegistry();
     PipelineBuilder builder;
-    auto shaderModule=loadShaderModule(vulkan.getDevice(), "shaders/sprites.spv");        
+    auto shaderModule=registry.getShaderModule("shaders/sprites.spv");        
     builder.shaders.push_back({ .stage=vk::ShaderStageFlagBits::eVertex, .module=shaderModule, .pName="vertMain"});
     builder.inputAssembly.topology = vk::PrimitiveTopology::eTriangleStrip;
     builder.shaders.push_back({ .stage=vk::ShaderStageFlagBits::eFragment, .module=shaderModule, .pName="fragMain"});
 
-    builder.multisample.rasterizationSamples = vk::SampleCountFlagBits::e4;
+    builder.multisample.rasterizationSamples = samples;
 
     builder.addColorAttachment(
         vulkan.getSwapChainFormat().format,
@@ -55,22 +79,109 @@ SpriteManager::SpriteManager(
             .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB
         }
     );
-    pipeline = builder.build(vulkan.getDevice(),pipelineLayout);
+    pipeline = registry.getPipeline(builder, pipelineLayout);
 }
 
 /*
 SpriteManager::Texture SpriteManager::recreateTexture(const string& name, const filesystem::path& filename)
 {
     releaseTexture(name);
-    return createTextureEntry(name, filename);
+    return createTextureEntry(name, createImageFromFile(filename, vulkan.getBufferManager()));
 }
 */
 
+bool SpriteManager::loadAtlas(const filesystem::path& manifest, JobSystem& jobs)
+{
+    auto in=ifstream(manifest);
+    if (!in) return false;
+
+    // "page <index> <file> <width> <height>" and "region <name> <page> <x> <y> <width> <height>"
+    struct Page
+    {
+        string file;
+        glm::vec2 size;
+    };
+    vector<Page> pages;
+    vector<pair<string, glm::vec4>> pageRegions;
+    vector<size_t> regionPages;
+    string line;
+    while (getline(in, line))
+    {
+        auto fields=istringstream(line);
+        string kind, name;
+        size_t index;
+        glm::vec4 rect;
+        fields >> kind;
+        if (kind=="page" && fields >> index >> name >> rect.x >> rect.y && index==pages.size())
+        {
+            pages.emplace_back((manifest.parent_path()/name).string(), glm::vec2{ rect.x, rect.y });
+        }
+        else if (kind=="region" && fields >> name >> index >> rect.x >> rect.y >> rect.z >> rect.w && index<pages.size())
+        {
+            pageRegions.emplace_back(name, rect);
+            regionPages.push_back(index);
+        }
+        else if (!kind.empty()) throw runtime_error("Invalid line '"+line+"' in texture atlas '"+manifest.string()+"'");
+    }
+
+    vector<ImageData> decoded(pages.size());
+    jobs.parallelFor(pages.size(), 1, [&](size_t begin, size_t end) {
+        for (auto i=begin; i<end; ++i) decoded[i]=decodeImageFile(pages[i].file);
+    });
+
+    vector<Region> pageEntries;
+    for (size_t i=0; i<pages.size(); ++i)
+    {
+        pageEntries.push_back(createTextureEntry(pages[i].file, createImageFromData(decoded[i], vulkan.getBufferManager())));
+    }
+    for (size_t i=0; i<pageRegions.size(); ++i)
+    {
+        auto& [name, rect]=pageRegions[i];
+        auto pageSize=pages[regionPages[i]].size;
+        atlas[name]=Region{
+            pageEntries[regionPages[i]].page,
+            { glm::vec2{ rect.x, rect.y }/pageSize, glm::vec2{ rect.z, rect.w }/pageSize },
+            { rect.z, rect.w }
+        };
+    }
+    return true;
+}
+
 SpriteManager::Texture SpriteManager::getOrCreateTexture(const string& name, const filesystem::path& filename)
 {
-    auto finder=textures.find(name);
-    if (finder==textures.end()) return createTextureEntry(name, filename);
-    else return finder->second.id;
+    if (auto finder=textureIds.find(name); finder!=textureIds.end()) return finder->second;
+    if (auto region=atlas.find(filename.stem().string()); region!=atlas.end()) return createRegion(name, region->second);
+    return createRegion(name, createTextureEntry(name, createImageFromFile(filename, vulkan.getBufferManager())));
+}
+
+SpriteManager::Texture SpriteManager::getTexture(const string& name) const
+{
+    auto finder=textureIds.find(name);
+    if (finder==textureIds.end()) throw runtime_error("Unknown texture "+name);
+    return finder->second;
+}
+
+void SpriteManager::preloadTextures(const vector<pair<string, filesystem::path>>& files, JobSystem& jobs)
+{
+    vector<pair<string, filesystem::path>> missing;
+    ranges::copy_if(files, back_inserter(missing), [this](auto&& f) {
+        return !textureIds.contains(f.first) && !atlas.contains(f.second.stem().string());
+    });
+
+    // decoding is pure CPU work, uploads have to stay on this thread
+    vector<ImageData> decoded(missing.size());
+    jobs.parallelFor(missing.size(), 1, [&](size_t begin, size_t end) {
+        for (auto i=begin; i<end; ++i) decoded[i]=decodeImageFile(missing[i].second);
+    });
+
+    for (size_t i=0; i<missing.size(); ++i)
+    {
+        if (textureIds.contains(missing[i].first)) continue; // listed twice
+        createRegion(missing[i].first, createTextureEntry(missing[i].first, createImageFromData(decoded[i], vulkan.getBufferManager())));
+    }
+
+    // the rest comes from the atlas
+    for (auto&& [name, file] : files) getOrCreateTexture(name, file);
 }
 /*
 void SpriteManager::releaseTexture(const string& name)
@@ -95,13 +206,13 @@ void SpriteManager::releaseTexture(const string& name)
 }
 */
 
-SpriteManager::Texture SpriteManager::createTextureEntry(const string& name, const filesystem::path& filename)
+SpriteManager::Region SpriteManager::createTextureEntry(const string& name, DeviceImage image)
 {
     if (freeTextureIds.empty()) throw runtime_error("Out of texture slots");
     SpriteManager::Texture textureId=freeTextureIds.back();
     freeTextureIds.pop_back();
 
-    auto [finder, newEntry] = textures.try_emplace(name, textureId, createImageFromFile(filename, vulkan.getBufferManager()), createSampler(vulkan.getPhysicalDevice(), vulkan.getDevice()));
+    auto [finder, newEntry] = textures.try_emplace(name, textureId, std::move(image), vulkan.getRegistry().getSampler());
     assert(newEntry);
 
     auto imageInfo = vk::DescriptorImageInfo
@@ -121,7 +232,18 @@ SpriteManager::Texture SpriteManager::createTextureEntry(const string& name, con
         }
     };
     vulkan.getDevice().updateDescriptorSets(descriptorWrites, {});
-    return textureId;
+
+    auto&& extent=finder->second.image.getDescription().extent;
+    return { textureId, { 0.0f, 0.0f, 1.0f, 1.0f }, { extent.width, extent.height } };
+}
+
+SpriteManager::Texture SpriteManager::createRegion(const string& name, const Region& region)
+{
+    if (regions.size()>numeric_limits<Texture>::max()) throw runtime_error("Out of texture regions");
+    auto id=static_cast<Texture>(regions.size());
+    regions.push_back(region);
+    textureIds[name]=id;
+    return id;
 }
 
 SpriteManager::Sprite SpriteManager::createSprite(
@@ -134,16 +256,14 @@ SpriteManager::Sprite SpriteManager::createSprite(
 {
     if (size.x==0)
     {
-        auto finder=find_if(textures.begin(), textures.end(), [texture](auto&& e) { return e.second.id==texture; });
-        if (finder==textures.end()) throw runtime_error("texture must be registered to use automatic sprite size");
-        auto&& desc=finder->second.image.getDescription();
-        size={ desc.extent.width, desc.extent.height };
+        if (texture>=regions.size()) throw runtime_error("texture must be registered to use automatic sprite size");
+        size=regions[texture].size;
     }
     auto& l = layers[layer];
     if (l.sprites.size()<l.sprites.capacity())
     {
         l.sprites.emplace_back(pos,size,color,texture);
-        return makeSprite(l.sprites.end()-1);
+        return makeSprite(l, l.sprites.end()-1);
     }
     else
     {
@@ -156,44 +276,160 @@ SpriteManager::Sprite SpriteManager::createSprite(
                 iter->color=color;
                 iter->texture=texture;
                 iter->valid=true;
-                return makeSprite(iter);
+                return makeSprite(l, iter);
             }
         }
     }
     throw runtime_error("out of sprites");
 }
 
-void SpriteManager::drawAllLayers(const vk::CommandBuffer& buffer) const
+vector<SpriteManager::Sprite> SpriteManager::createSprites(size_t layer, span<const SpriteData> data)
 {
-    buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
-    for (const auto& l : layers)
+    auto& l = layers[layer];
+    vector<Sprite> result;
+    result.reserve(data.size());
+
+    // the container never grows beyond its capacity, so iterators stay valid
+    auto freeSlot=l.sprites.begin();
+    for (auto&& d : data)
     {
-        buffer.pushConstants<glm::mat4>(pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, l.transformation);
-        for (auto&& s : l.sprites)
+        if (l.sprites.size()<l.sprites.capacity())
         {
-            if (!s.valid) continue;
+            l.sprites.emplace_back(d.pos, d.size, d.color, d.texture);
+            result.push_back(makeSprite(l, l.sprites.end()-1));
+            continue;
+        }
+
+        while (freeSlot!=l.sprites.end() && freeSlot->valid) ++freeSlot;
+        if (freeSlot==l.sprites.end()) throw runtime_error("out of sprites");
+        static_cast<SpriteData&>(*freeSlot)=d;
+        freeSlot->valid=true;
+        result.push_back(makeSprite(l, freeSlot));
+    }
+    return result;
+}
+
+void SpriteManager::setLayerCached(size_t layer, bool cached)
+{
+    auto& l=layers[layer];
+    if (!cached) retireCache(l);
+    l.cached=cached;
+    l.cacheValid=false;
+}
+
+void SpriteManager::resizeCaches(const vk::Extent2D& extent)
+{
+    for (auto& l : layers)
+    {
+        if (!l.cached) continue;
+
+        // frames in flight still sample the old cache, so it gets a new image and descriptor set
+        retireCache(l);
+        l.cache=make_unique<ImageRenderTarget>();
+        l.cache->reset({ .extent=extent, .format=vulkan.getSwapChainFormat().format }, 1, samples);
+        l.cacheValid=false;
+        tie(l.cachePool, l.cacheDescriptors)=getDescriptorBuilder().buildPoolAndSets(vulkan.getDevice(), descriptorLayout, 1);
 
-            buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, *descriptors[s.texture], {});
+        auto imageInfo = vk::DescriptorImageInfo
+        {
+            .sampler = vulkan.getRegistry().getSampler(),
+            .imageView = l.cache->getCurrent(),
+            .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
+        };
+        std::array descriptorWrites{
+            vk::WriteDescriptorSet{
+                .dstSet=l.cacheDescriptors[0],
+                .dstBinding=0,
+                .descriptorCount=1,
+                .descriptorType=vk::DescriptorType::eCombinedImageSampler,
+                .pImageInfo=&imageInfo
+            }
+        };
+        vulkan.getDevice().updateDescriptorSets(descriptorWrites, {});
+    }
+}
 
-            buffer.pushConstants<SpritePushData>(pipelineLayout, vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4), s);
-            buffer.draw(4,1,0,0);
+void SpriteManager::retireCache(Layer& layer)
+{
+    if (!layer.cache) return;
+    vulkan.retire(std::move(layer.cache));
+    vulkan.retire(pair(std::move(layer.cachePool), std::move(layer.cacheDescriptors)));
+    layer.cache=nullptr;
+    layer.cachePool=nullptr;
+    layer.cacheDescriptors=nullptr;
+    layer.cacheValid=false;
+}
+
+void SpriteManager::updateCaches(const vk::CommandBuffer& commandBuffer)
+{
+    for (auto& l : layers)
+    {
+        // a cache made for another sample count waits for resizeCaches, the layer is drawn as usual until then
+        if (!l.cached || l.cacheValid || !l.cache || l.cache->getSamples()!=samples) continue;
+
+        PROFILE_ZONE("SpriteManager::updateCache");
+        // the scene is cleared to opaque black as well, and the sprites don't write alpha
+        l.cache->beginRenderTo(commandBuffer, vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f));
+        {
+            CountingCommandBuffer buffer(commandBuffer, Profiler::Sprites);
+            buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+            drawSprites(buffer, l);
         }
+        l.cache->endRenderTo(commandBuffer);
+        l.cache->getCurrent().transition(commandBuffer, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead, vk::ImageLayout::eShaderReadOnlyOptimal);
+        l.cacheValid=true;
     }
 }
 
-void SpriteManager::drawLayer(size_t layer, const vk::CommandBuffer& buffer) const
+void SpriteManager::drawAllLayers(const vk::CommandBuffer& commandBuffer) const
 {
+    CountingCommandBuffer buffer(commandBuffer, Profiler::Sprites);
     buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
-    const auto& l =layers[layer];
-    buffer.pushConstants<glm::mat4>(pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, l.transformation);
-    for (auto&& s : l.sprites)
+    for (const auto& l : layers)
+    {
+        if (l.cached && l.cacheValid) drawCache(buffer, l);
+        else drawSprites(buffer, l);
+    }
+}
+
+void SpriteManager::drawLayer(size_t layer, const vk::CommandBuffer& commandBuffer) const
+{
+    PROFILE_ZONE("SpriteManager::drawLayer");
+    CountingCommandBuffer buffer(commandBuffer, Profiler::Sprites);
+    buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+    const auto& l=layers[layer];
+    if (l.cached && l.cacheValid) drawCache(buffer, l);
+    else drawSprites(buffer, l);
+}
+
+void SpriteManager::drawCache(CountingCommandBuffer& buffer, const Layer& layer) const
+{
+    // one sprite over the whole target, the cache has the same resolution
+    buffer.pushConstants<glm::mat4>(pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, glm::mat4(1.0f));
+    buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, *layer.cacheDescriptors[0], {});
+    buffer.pushConstants<SpriteDrawData>(pipelineLayout, vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4),
+        SpriteDrawData{ SpritePushData{ { 0.0f, 0.0f }, { 2.0f, 2.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } }, { 0.0f, 0.0f, 1.0f, 1.0f } });
+    buffer.draw(4,1,0,0);
+}
+
+void SpriteManager::drawSprites(CountingCommandBuffer& buffer, const Layer& layer) const
+{
+    buffer.pushConstants<glm::mat4>(pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, layer.transformation);
+
+    // sprites from the same atlas page share the descriptor set, only bind on changes
+    optional<Texture> boundPage;
+    for (auto&& s : layer.sprites)
     {
         if (!s.valid) continue;
 
-        buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, *descriptors[s.texture], {});
+        const auto& region=regions[s.texture];
+        if (region.page!=boundPage)
+        {
+            buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, *descriptors[region.page], {});
+            boundPage=region.page;
+        }
 
-        buffer.pushConstants<SpritePushData>(pipelineLayout, vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4), s);
+        buffer.pushConstants<SpriteDrawData>(pipelineLayout, vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4), SpriteDrawData{ s, region.uv });
         buffer.draw(4,1,0,0);
     }
 }
-
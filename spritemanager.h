@@ -5,7 +5,12 @@
 
 #include "common.h"
 #include "texture.h"
+#include "imagerendertarget.h"
+#include "jobsystem.h"
 #include <glm/glm.hpp>
+#include <span>
+
+class CountingCommandBuffer;
 
 class SpriteManager
 {
@@ -75,11 +80,26 @@ private:
         friend class SpriteManager;
     };
 
+    // what the shader gets per sprite
+    struct SpriteDrawData : public SpritePushData
+    {
+        glm::vec4 uv;   // offset and scale of the texture region
+    };
+
+    //! an image with its own descriptor set, either a whole texture or an atlas page
     struct TextureEntry
     {
-        Texture id;
+        Texture id;     // descriptor set index
         DeviceImage image;
-        vk::raii::Sampler sampler;
+        vk::Sampler sampler;
+    };
+
+    //! the part of an image a Texture refers to
+    struct Region
+    {
+        Texture page;           // descriptor set index of the image
+        glm::vec4 uv;           // offset and scale in the image
+        glm::vec2 size;         // in pixels
     };
 
 public:
@@ -87,23 +107,43 @@ public:
 
 private:
     using Container = vector<SpriteEntry>;
-    inline Sprite makeSprite(Container::iterator iter)
-    {
-        return Sprite(&*iter, [](SpriteEntry* e){e->valid=false;});
-    };
 
 public:
     struct Layer
     {
         Container sprites;
         glm::mat4 transformation = glm::mat4(1.0f);
+
+        // see setLayerCached
+        bool cached = false;
+        bool cacheValid = false;
+        unique_ptr<ImageRenderTarget> cache;
+        vk::raii::DescriptorPool cachePool = nullptr;       // a set of its own, replaced with the cache
+        vk::raii::DescriptorSets cacheDescriptors = nullptr;
+    };
+
+private:
+    //! releasing a sprite of a cached layer has to redraw the cache
+    inline Sprite makeSprite(Layer& layer, Container::iterator iter)
+    {
+        layer.cacheValid=false;
+        return Sprite(&*iter, [&layer](SpriteEntry* e){ e->valid=false; layer.cacheValid=false; });
     };
 
 public:
     SpriteManager(size_t layers=1, size_t maxSpritesPerLayer=1024, size_t maxTextures=256);
 
 //    Texture recreateTexture(const string& name, const filesystem::path& filename);
+    //! load a texture atlas built by add_texture_atlas. Textures whose file
+    //! name (without extension) is found in the atlas are taken from it,
+    //! all others are still loaded from their own file. Returns false if
+    //! there is no atlas.
+    bool loadAtlas(const filesystem::path& manifest, JobSystem& jobs);
     Texture getOrCreateTexture(const string& name, const filesystem::path& filename);
+    //! a texture created before, throws if there is none with this name
+    Texture getTexture(const string& name) const;
+    //! decode all textures that are not loaded yet in parallel and upload them
+    void preloadTextures(const vector<pair<string, filesystem::path>>& files, JobSystem& jobs);
 //    void releaseTexture(const string& name);
 
     Sprite createSprite(
@@ -113,22 +153,52 @@ public:
         glm::vec2 size = Automatic,
         glm::vec4 color = { 1.0f, 1.0f, 1.0f, 1.0f }
     );
+    //! create many sprites at once, looking for free slots only once
+    vector<Sprite> createSprites(size_t layer, span<const SpriteData> data);
+
+    //! @brief a cached layer is drawn once into an image of the screen's
+    //! resolution and then composited with a single draw. The image covers
+    //! everything below it, so this is meant for layers at the bottom whose
+    //! sprites rarely change. Changing a sprite through its pointer needs an
+    //! invalidateLayer, creating and releasing sprites invalidates by itself.
+    void setLayerCached(size_t layer, bool cached);
+    inline void invalidateLayer(size_t layer) noexcept { layers[layer].cacheValid=false; }
+    //! selects the pipeline for render targets with this many samples, the caches
+    //! follow with the next resizeCaches
+    void setSamples(vk::SampleCountFlagBits samples);
+    //! (re)creates the cache images, call when the screen size or the samples change
+    void resizeCaches(const vk::Extent2D& extent);
+    //! redraws invalid caches, outside of any rendering
+    void updateCaches(const vk::CommandBuffer& buffer);
 
     void drawAllLayers(const vk::CommandBuffer& buffer) const;
     void drawLayer(size_t layer, const vk::CommandBuffer& buffer) const;
 
-    inline void setLayerTransform(size_t layer, const glm::mat4& transform) { layers[layer].transformation = transform; }
+    inline void setLayerTransform(size_t layer, const glm::mat4& transform)
+    {
+        if (layers[layer].transformation!=transform) layers[layer].cacheValid=false;
+        layers[layer].transformation = transform;
+    }
     
 private:
-    vk::raii::PipelineLayout pipelineLayout;
-    vk::raii::Pipeline pipeline;
-    vk::raii::DescriptorSetLayout descriptorLayout;
+    vk::PipelineLayout pipelineLayout;      // shared through PipelineRegistry
+    vk::Pipeline pipeline;
+    vk::SampleCountFlagBits samples;
+    vk::DescriptorSetLayout descriptorLayout;
     vk::raii::DescriptorPool descriptorPool;
     vk::raii::DescriptorSets descriptors;
     
     vector<Layer> layers;
-    map<string, TextureEntry> textures;
-    vector<Texture> freeTextureIds;
-
-    Texture createTextureEntry(const string& name, const filesystem::path& filename);
+    map<string, TextureEntry> textures;     // images by name
+    vector<Texture> freeTextureIds;         // unused descriptor sets
+    map<string, Region> atlas;              // atlas regions by file name
+    map<string, Texture> textureIds;        // regions by texture name
+    vector<Region> regions;                 // indexed by Texture
+
+    Region createTextureEntry(const string& name, DeviceImage image);
+    Texture createRegion(const string& name, const Region& region);
+    void drawSprites(CountingCommandBuffer& buffer, const Layer& layer) const;
+    void drawCache(CountingCommandBuffer& buffer, const Layer& layer) const;
+    //! keeps the cache alive for the frames in flight and drops it from the layer
+    void retireCache(Layer& layer);
 };
\ No newline at end of file
@@ -4,31 +4,30 @@
 
 #include "swapchain.h"
 #include "vulkan.h"
+#include "profiler.h"
 
-SwapChain::SwapChain(uint32_t maxFramesInFlight) :
+SwapChain::Frame::Frame(vk::CommandPool commandPool) :
+    commandBuffer(std::move(vk::raii::CommandBuffers(vulkan.getDevice(), vk::CommandBufferAllocateInfo
+    {
+        .commandPool = commandPool,
+        .level = vk::CommandBufferLevel::ePrimary,
+        .commandBufferCount = 1
+    }).front())),
+    presentComplete(vulkan.getDevice(), vk::SemaphoreCreateInfo{}),
+    renderFinished(vulkan.getDevice(), vk::SemaphoreCreateInfo{}),
+    number(0)
+{
+}
+
+SwapChain::SwapChain() :
     RenderTarget(),
     commandPool(vulkan.getDevice(), vk::CommandPoolCreateInfo
     {
         .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
         .queueFamilyIndex = vulkan.getGraphicsQueueIndex()
     }),
-    commandBuffers(vulkan.getDevice(), vk::CommandBufferAllocateInfo 
-    {
-        .commandPool = commandPool,
-        .level = vk::CommandBufferLevel::ePrimary,
-        .commandBufferCount = maxFramesInFlight
-    }),
-    presentCompleteSemaphores(),
-    renderFinishedSemaphores(),
-    inFlightFences(),
-    currentFrame(0)
+    frames(*commandPool)
 {
-    for (auto i=0; i<maxFramesInFlight; ++i)
-    {
-        presentCompleteSemaphores.emplace_back(vulkan.getDevice(), vk::SemaphoreCreateInfo{});
-        renderFinishedSemaphores.emplace_back(vulkan.getDevice(), vk::SemaphoreCreateInfo{});
-        inFlightFences.emplace_back(vulkan.getDevice(), vk::FenceCreateInfo{.flags = vk::FenceCreateFlagBits::eSignaled});
-    }
 }
 
 void SwapChain::cleanup()
@@ -42,20 +41,24 @@ void SwapChain::reset(
    const SwapChainRequirements& requirements
 )
 {
-    cleanup();
-    
-    tie(chain, description.format, description.extent) = createSwapChain(vulkan.getPhysicalDevice(), vulkan.getDevice(), vulkan.getSurface(), vulkan.getSwapChainFormat(), requirements);
+    auto oldChain=std::move(chain);
+    tie(chain, description.format, description.extent, usage) = createSwapChain(vulkan.getPhysicalDevice(), vulkan.getDevice(), vulkan.getSurface(), vulkan.getSwapChainFormat(), requirements, *oldChain);
+    renderExtent=description.extent;
+
+    // the views go before the chain owning their images
+    if (*oldChain) vulkan.retire(pair(std::move(oldChain), std::move(images)));
+    images.clear();
     for (auto&& image: chain.getImages()) images.emplace_back(DeviceImage(description, image));
     current=images.begin();
 }
 
 bool SwapChain::waitForNextFrame()
 {
-    while ( vk::Result::eTimeout == vulkan.getDevice().waitForFences( *inFlightFences[currentFrame], vk::True, UINT64_MAX ) )
-        ;
+    auto& frame=frames.current();
+    vulkan.waitForFrame(frame.number);
 
     vk::Result result;
-    tie(result, currentImage) = chain.acquireNextImage( UINT64_MAX, presentCompleteSemaphores[currentFrame], nullptr );
+    tie(result, currentImage) = chain.acquireNextImage( UINT64_MAX, frame.presentComplete, nullptr );
     current=images.begin()+currentImage;
 
     if (result == vk::Result::eErrorOutOfDateKHR) {
@@ -64,14 +67,18 @@ bool SwapChain::waitForNextFrame()
     if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
         throw std::runtime_error("failed to acquire swap chain image!");
     }
+    // the first barrier on the image has to wait for the stages the acquire semaphore blocks
+    current->currentStage=AcquireStages;
+    current->currentAccess=vk::AccessFlagBits2::eNone;
     return false;
 }
 
 vk::raii::CommandBuffer& SwapChain::beginFrame()
 {
-    vulkan.getDevice().resetFences( *inFlightFences[currentFrame] );
+    auto& frame=frames.current();
+    frame.number=vulkan.beginFrame();
 
-    vk::raii::CommandBuffer& commandBuffer = commandBuffers[currentFrame];
+    vk::raii::CommandBuffer& commandBuffer = frame.commandBuffer;
     commandBuffer.reset();
     commandBuffer.begin({});
 
@@ -80,25 +87,32 @@ vk::raii::CommandBuffer& SwapChain::beginFrame()
 
 bool SwapChain::endFrame(const vk::CommandBuffer& commandBuffer)
 {
+    PROFILE_ZONE("SwapChain::endFrame");
     current->transition(commandBuffer, vk::PipelineStageFlagBits2::eBottomOfPipe, vk::AccessFlagBits2::eNone, vk::ImageLayout::ePresentSrcKHR);
     commandBuffer.end();
 
-    auto waitDestinationStageMask = vk::PipelineStageFlags( vk::PipelineStageFlagBits::eColorAttachmentOutput );
-    auto submitInfo=vk::SubmitInfo{};
-    submitInfo.setCommandBuffers(commandBuffer);
-    submitInfo.setWaitSemaphores(*presentCompleteSemaphores[currentFrame]);
-    submitInfo.setWaitDstStageMask(waitDestinationStageMask);
-    submitInfo.setSignalSemaphores(*renderFinishedSemaphores[currentFrame]);
-
-    vulkan.getGraphicsQueue().submit(submitInfo, *inFlightFences[currentFrame]);
+    auto& frame=frames.current();
+    // rendering waits for the acquire, the frame's number on the timeline tells the CPU it is done
+    auto waitInfo=vk::SemaphoreSubmitInfo{ .semaphore = frame.presentComplete, .stageMask = AcquireStages };
+    std::array signalInfos{
+        vk::SemaphoreSubmitInfo{ .semaphore = frame.renderFinished, .stageMask = vk::PipelineStageFlagBits2::eAllCommands },
+        vk::SemaphoreSubmitInfo{ .semaphore = vulkan.getFrameTimeline(), .value = frame.number, .stageMask = vk::PipelineStageFlagBits2::eAllCommands }
+    };
+    auto commandBufferInfo=vk::CommandBufferSubmitInfo{ .commandBuffer = commandBuffer };
+    auto submitInfo=vk::SubmitInfo2{};
+    submitInfo.setWaitSemaphoreInfos(waitInfo);
+    submitInfo.setCommandBufferInfos(commandBufferInfo);
+    submitInfo.setSignalSemaphoreInfos(signalInfos);
+
+    vulkan.getGraphicsQueue().submit2(submitInfo);
 
     auto presentInfo=vk::PresentInfoKHR{};
-    presentInfo.setWaitSemaphores(*renderFinishedSemaphores[currentFrame]);
+    presentInfo.setWaitSemaphores(*frame.renderFinished);
     presentInfo.setSwapchains(*chain);
     presentInfo.setImageIndices(currentImage);
     auto result = vulkan.getPresentQueue().presentKHR(presentInfo);
 
-    currentFrame=(currentFrame+1)%commandBuffers.size();
+    frames.cycle();
 
     if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR) {
         return true;        
@@ -6,15 +6,21 @@
 #include "common.h"
 #include "rendertarget.h"
 #include "vkutils.h"
+#include "dynamicresource.h"
 
 class SwapChain : public RenderTarget
 {
 public:
-    SwapChain(
-        uint32_t maxFramesInFlight=2
-    );
+    //! what waits for the image to be acquired, the scene is either drawn or blitted to it
+    static constexpr vk::PipelineStageFlags2 AcquireStages = vk::PipelineStageFlagBits2::eColorAttachmentOutput | vk::PipelineStageFlagBits2::eAllTransfer;
+
+    SwapChain();
 
+    //! waits for the device to idle, only for shutting down
     void cleanup();
+    //! a new chain for the current surface size. The old chain and its images live
+    //! on until the frames in flight are done with them, nothing waits for the device.
+    //! Call it between endFrame and the next waitForNextFrame.
     void reset(
         const SwapChainRequirements& requirements={}
     );
@@ -24,14 +30,26 @@ public:
 
     bool endFrame(const vk::CommandBuffer& commandBuffer);
 
+    inline size_t getCurrentFrame() const noexcept { return frames.getIndex(); }
+    static constexpr size_t getFramesInFlight() noexcept { return FramesInFlight; }
+
 private:
+    //! @brief what one frame in flight needs until the GPU is done with it. The
+    //! frame's number on Vulkan's frame timeline tells when that is, acquire and
+    //! present still need binary semaphores.
+    struct Frame
+    {
+        Frame(vk::CommandPool commandPool);
+
+        vk::raii::CommandBuffer commandBuffer;
+        vk::raii::Semaphore presentComplete;
+        vk::raii::Semaphore renderFinished;
+        uint64_t number;                // of the frame last submitted with it
+    };
+
     vk::raii::CommandPool commandPool;
-    vk::raii::CommandBuffers commandBuffers;
-    vector<vk::raii::Semaphore> presentCompleteSemaphores;
-    vector<vk::raii::Semaphore> renderFinishedSemaphores;
-    vector<vk::raii::Fence> inFlightFences;
+    PerFrame<Frame> frames;
 
-    size_t currentFrame;
     uint32_t currentImage;
     vk::raii::SwapchainKHR chain = nullptr;
 };
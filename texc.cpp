@@ -0,0 +1,282 @@
+//!@author mucki (code@mucki.dev)
+//!@copyright Copyright (c) 2025
+//! please see LICENSE file in root folder for licensing terms.
+
+#include "common.h"
+#include "imagefile.h"
+#include <array>
+#include <cmath>
+
+namespace
+{
+    using Pixel = array<uint8_t, 4>;
+
+    struct Mip
+    {
+        uint32_t width;
+        uint32_t height;
+        vector<Pixel> pixels;
+
+        inline const Pixel& at(uint32_t x, uint32_t y) const noexcept { return pixels[size_t(min(y, height-1))*width+min(x, width-1)]; }
+    };
+
+    float toLinear(uint8_t value)
+    {
+        auto v=value/255.0f;
+        return v<=0.04045f ? v/12.92f : pow((v+0.055f)/1.055f, 2.4f);
+    }
+
+    uint8_t toSrgb(float value)
+    {
+        auto v=value<=0.0031308f ? value*12.92f : 1.055f*pow(value, 1.0f/2.4f)-0.055f;
+        return uint8_t(clamp(v, 0.0f, 1.0f)*255.0f+0.5f);
+    }
+
+    //! 2x2 box filter in linear space. Colors are weighted by alpha so
+    //! transparent pixels don't darken the edges of sprites.
+    Mip downsample(const Mip& source)
+    {
+        static const auto linear=[] {
+            array<float, 256> table;
+            for (size_t i=0; i<table.size(); ++i) table[i]=toLinear(uint8_t(i));
+            return table;
+        }();
+
+        Mip result{ max(source.width/2, 1u), max(source.height/2, 1u), {} };
+        result.pixels.resize(size_t(result.width)*result.height);
+        for (uint32_t y=0; y<result.height; ++y)
+        {
+            for (uint32_t x=0; x<result.width; ++x)
+            {
+                float color[3]={}, alpha=0.0f, weights=0.0f;
+                for (auto [dx, dy] : { pair{0u, 0u}, {1u, 0u}, {0u, 1u}, {1u, 1u} })
+                {
+                    auto& p=source.at(2*x+dx, 2*y+dy);
+                    auto weight=max(p[3]/255.0f, 1.0f/1024.0f);
+                    for (size_t c=0; c<3; ++c) color[c]+=linear[p[c]]*weight;
+                    weights+=weight;
+                    alpha+=p[3]/255.0f;
+                }
+                auto& p=result.pixels[size_t(y)*result.width+x];
+                for (size_t c=0; c<3; ++c) p[c]=toSrgb(color[c]/weights);
+                p[3]=uint8_t(alpha/4.0f*255.0f+0.5f);
+            }
+        }
+        return result;
+    }
+
+    uint16_t to565(const float color[3])
+    {
+        auto r=uint16_t(clamp(color[0], 0.0f, 255.0f)*31.0f/255.0f+0.5f);
+        auto g=uint16_t(clamp(color[1], 0.0f, 255.0f)*63.0f/255.0f+0.5f);
+        auto b=uint16_t(clamp(color[2], 0.0f, 255.0f)*31.0f/255.0f+0.5f);
+        return uint16_t((r<<11) | (g<<5) | b);
+    }
+
+    array<int, 3> from565(uint16_t color)
+    {
+        int r=(color>>11)&31, g=(color>>5)&63, b=color&31;
+        return { (r<<3)|(r>>2), (g<<2)|(g>>4), (b<<3)|(b>>2) };
+    }
+
+    //! @brief BC1 color block in four color mode. The end points are the extremes
+    //! of the colors along their principal axis, every pixel gets the closest of
+    //! the four palette colors.
+    void encodeColorBlock(const array<Pixel, 16>& block, uint8_t* out)
+    {
+        float mean[3]={};
+        for (auto&& p : block) for (size_t c=0; c<3; ++c) mean[c]+=p[c]/16.0f;
+
+        float covariance[3][3]={};
+        for (auto&& p : block)
+        {
+            float d[3]={ p[0]-mean[0], p[1]-mean[1], p[2]-mean[2] };
+            for (size_t i=0; i<3; ++i) for (size_t j=0; j<3; ++j) covariance[i][j]+=d[i]*d[j];
+        }
+        float axis[3]={ 1.0f, 1.0f, 1.0f };
+        for (int iteration=0; iteration<8; ++iteration)
+        {
+            float next[3]={};
+            for (size_t i=0; i<3; ++i) for (size_t j=0; j<3; ++j) next[i]+=covariance[i][j]*axis[j];
+            auto length=max({ abs(next[0]), abs(next[1]), abs(next[2]) });
+            if (length<1e-6f) break;
+            for (size_t i=0; i<3; ++i) axis[i]=next[i]/length;
+        }
+
+        float low=numeric_limits<float>::max(), high=numeric_limits<float>::lowest();
+        for (auto&& p : block)
+        {
+            auto t=(p[0]-mean[0])*axis[0]+(p[1]-mean[1])*axis[1]+(p[2]-mean[2])*axis[2];
+            low=min(low, t);
+            high=max(high, t);
+        }
+        auto axisLength=axis[0]*axis[0]+axis[1]*axis[1]+axis[2]*axis[2];
+        float lowColor[3], highColor[3];
+        for (size_t c=0; c<3; ++c)
+        {
+            lowColor[c]=mean[c]+axis[c]*low/axisLength;
+            highColor[c]=mean[c]+axis[c]*high/axisLength;
+        }
+
+        // four color mode needs the first end point to be the larger one
+        auto color0=to565(highColor), color1=to565(lowColor);
+        if (color0<color1) swap(color0, color1);
+
+        uint32_t indices=0;
+        if (color0!=color1)
+        {
+            auto c0=from565(color0), c1=from565(color1);
+            array<array<int, 3>, 4> palette={ c0, c1 };
+            for (size_t c=0; c<3; ++c)
+            {
+                palette[2][c]=(2*c0[c]+c1[c])/3;
+                palette[3][c]=(c0[c]+2*c1[c])/3;
+            }
+            for (size_t i=0; i<block.size(); ++i)
+            {
+                uint32_t best=0;
+                int bestDistance=numeric_limits<int>::max();
+                for (uint32_t j=0; j<palette.size(); ++j)
+                {
+                    int distance=0;
+                    for (size_t c=0; c<3; ++c) distance+=(block[i][c]-palette[j][c])*(block[i][c]-palette[j][c]);
+                    if (distance<bestDistance)
+                    {
+                        best=j;
+                        bestDistance=distance;
+                    }
+                }
+                indices|=best<<(2*i);
+            }
+        }
+
+        out[0]=uint8_t(color0);
+        out[1]=uint8_t(color0>>8);
+        out[2]=uint8_t(color1);
+        out[3]=uint8_t(color1>>8);
+        for (size_t i=0; i<4; ++i) out[4+i]=uint8_t(indices>>(8*i));
+    }
+
+    //! BC3 alpha block in eight value mode between the smallest and largest alpha
+    void encodeAlphaBlock(const array<Pixel, 16>& block, uint8_t* out)
+    {
+        int alpha0=0, alpha1=255;
+        for (auto&& p : block)
+        {
+            alpha0=max<int>(alpha0, p[3]);
+            alpha1=min<int>(alpha1, p[3]);
+        }
+
+        uint64_t indices=0;
+        if (alpha0!=alpha1)
+        {
+            array<int, 8> palette={ alpha0, alpha1 };
+            for (int i=2; i<8; ++i) palette[i]=((8-i)*alpha0+(i-1)*alpha1)/7;
+            for (size_t i=0; i<block.size(); ++i)
+            {
+                uint64_t best=0;
+                for (uint64_t j=1; j<palette.size(); ++j)
+                {
+                    if (abs(block[i][3]-palette[j])<abs(block[i][3]-palette[best])) best=j;
+                }
+                indices|=best<<(3*i);
+            }
+        }
+
+        out[0]=uint8_t(alpha0);
+        out[1]=uint8_t(alpha1);
+        for (size_t i=0; i<6; ++i) out[2+i]=uint8_t(indices>>(8*i));
+    }
+
+    void encode(const Mip& mip, vk::Format format, vector<byte>& out)
+    {
+        if (format==vk::Format::eR8G8B8A8Srgb)
+        {
+            auto bytes=reinterpret_cast<const byte*>(mip.pixels.data());
+            out.insert(out.end(), bytes, bytes+mip.pixels.size()*sizeof(Pixel));
+            return;
+        }
+
+        auto blockBytes=getFormatBlock(format).bytes;
+        array<Pixel, 16> block;
+        for (uint32_t y=0; y<mip.height; y+=4)
+        {
+            for (uint32_t x=0; x<mip.width; x+=4)
+            {
+                // blocks over the edge repeat the last row and column
+                for (uint32_t i=0; i<16; ++i) block[i]=mip.at(x+i%4, y+i/4);
+                auto offset=out.size();
+                out.resize(offset+blockBytes);
+                auto data=reinterpret_cast<uint8_t*>(out.data()+offset);
+                if (format==vk::Format::eBc3SrgbBlock)
+                {
+                    encodeAlphaBlock(block, data);
+                    data+=8;
+                }
+                encodeColorBlock(block, data);
+            }
+        }
+    }
+}
+
+//! @brief encodes an image into a KTX2 texture with the full mip chain for
+//! SpriteManager and the particle systems. Runs on the CPU at build time,
+//! the game uploads the result without touching the pixels.
+//!   bc1   - opaque images, 4 bits per pixel
+//!   bc3   - images with alpha, 8 bits per pixel
+//!   rgba8 - no compression, mipmaps only
+//!   auto  - bc1 when every pixel is opaque, otherwise bc3 (default)
+int main(int argc, char* argv[])
+try {
+    const auto usage="Usage: texc [--format auto|bc1|bc3|rgba8] [--max-levels N] input output.ktx2"s;
+    string format="auto";
+    uint32_t maxLevels=numeric_limits<uint32_t>::max();
+    vector<string> files;
+    for (int i=1; i<argc; ++i)
+    {
+        auto arg=string_view(argv[i]);
+        if (arg=="--format" && i+1<argc) format=argv[++i];
+        else if (arg=="--max-levels" && i+1<argc) maxLevels=max<uint32_t>(stoul(argv[++i]), 1);
+        else if (arg.starts_with("--")) throw runtime_error("unknown argument '"s+argv[i]+"'. "+usage);
+        else files.push_back(argv[i]);
+    }
+    if (files.size()!=2) throw runtime_error(usage);
+
+    auto source=readImageFile(files[0]);
+    if (source.format!=vk::Format::eR8G8B8A8Srgb || source.levels.size()!=1) throw runtime_error("'"+files[0]+"' is already a texture");
+
+    Mip mip{ source.extent.width, source.extent.height, vector<Pixel>(size_t(source.extent.width)*source.extent.height) };
+    memcpy(mip.pixels.data(), source.pixels.data(), mip.pixels.size()*sizeof(Pixel));
+
+    ImageData result{ .extent=source.extent };
+    if (format=="auto")
+    {
+        auto opaque=ranges::all_of(mip.pixels, [](const Pixel& p) { return p[3]==255; });
+        result.format=opaque ? vk::Format::eBc1RgbSrgbBlock : vk::Format::eBc3SrgbBlock;
+    }
+    else if (format=="bc1") result.format=vk::Format::eBc1RgbSrgbBlock;
+    else if (format=="bc3") result.format=vk::Format::eBc3SrgbBlock;
+    else if (format=="rgba8") result.format=vk::Format::eR8G8B8A8Srgb;
+    else throw runtime_error("unknown format '"+format+"'. "+usage);
+
+    auto levels=min(uint32_t(floor(log2(max(mip.width, mip.height))))+1, maxLevels);
+    for (uint32_t i=0; i<levels; ++i)
+    {
+        if (i>0) mip=downsample(mip);
+        auto offset=result.pixels.size();
+        encode(mip, result.format, result.pixels);
+        result.levels.emplace_back(offset, result.pixels.size()-offset);
+    }
+    writeKtx2(files[1], result);
+    return 0;
+}
+catch (runtime_error& e)
+{
+    cerr << "runtime error: " << e.what() << std::endl;
+    return 2;
+}
+catch (...)
+{
+    cerr << "unknown error" << std::endl;
+    return -1;
+}
@@ -3,32 +3,62 @@
 //! please see LICENSE file in root folder for licensing terms.
 
 #include "texture.h"
-#include "stb_image.h"
+#include "vulkan.h"
 
-[[nodiscard]] DeviceImage createImageFromFile(
-    const string& filename,
-    const BufferManager& bufferManager
-)
+namespace
 {
-    int width, height, channels;
-    stbi_uc* pixels = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
-    if (!pixels) {
-        throw std::runtime_error("failed to load texture image!");
+    [[nodiscard]] bool canSample(vk::Format format)
+    {
+        if (format!=vk::Format::eR8G8B8A8Srgb && !vulkan.getEnabledFeatures().textureCompressionBC) return false;
+        auto features=vulkan.getPhysicalDevice().getFormatProperties(format).optimalTilingFeatures;
+        return bool(features & vk::FormatFeatureFlagBits::eSampledImage);
     }
+}
 
+[[nodiscard]] ImageData decodeImageFile(const string& filename)
+{
+    auto compressed=filesystem::path(filename).replace_extension(".ktx2");
+    if (filesystem::exists(compressed))
+    {
+        auto data=readImageFile(compressed);
+        if (canSample(data.format)) return data;
+    }
+    return readImageFile(filename);
+}
+
+[[nodiscard]] DeviceImage createImageFromData(
+    const ImageData& data,
+    const BufferManager& bufferManager
+)
+{
     auto desc = ImageDescription
     {
-        .extent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) },
-        .format = vk::Format::eR8G8B8A8Srgb
+        .extent = data.extent,
+        .format = data.format,
+        .mipLevels = static_cast<uint32_t>(data.levels.size())
     };
-    auto byteSize = static_cast<vk::DeviceSize>(width) * static_cast<vk::DeviceSize>(height) * 4;
     auto image = bufferManager.createImage(desc, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst);
-    memcpy(bufferManager.getStage(0, byteSize), pixels, byteSize);
-    bufferManager.upload(image, vk::BufferImageCopy{
-            .imageExtent = { desc.extent.width, desc.extent.height, 1 },
-            .imageSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 }
+
+    // all levels go up in one copy, straight from the file contents
+    memcpy(bufferManager.getStage(0, data.pixels.size()), data.pixels.data(), data.pixels.size());
+    vector<vk::BufferImageCopy> regions;
+    for (uint32_t i=0; i<desc.mipLevels; ++i)
+    {
+        regions.push_back(vk::BufferImageCopy{
+            .bufferOffset = data.levels[i].offset,
+            .imageSubresource = { vk::ImageAspectFlagBits::eColor, i, 0, 1 },
+            .imageExtent = { max(desc.extent.width>>i, 1u), max(desc.extent.height>>i, 1u), 1 }
         });
-    stbi_image_free(pixels);
+    }
+    bufferManager.upload(image, regions);
 
     return image;
-}
\ No newline at end of file
+}
+
+[[nodiscard]] DeviceImage createImageFromFile(
+    const string& filename,
+    const BufferManager& bufferManager
+)
+{
+    return createImageFromData(decodeImageFile(filename), bufferManager);
+}
@@ -5,6 +5,17 @@
 
 #include "common.h"
 #include "buffermanager.h"
+#include "imagefile.h"
+
+//! @brief load an image file on the CPU, using the compressed and mipmapped
+//! .ktx2 version the build writes next to it when there is one (see texc.cpp)
+//! and the device can sample its format. Safe to call from worker threads.
+[[nodiscard]] ImageData decodeImageFile(const string& filename);
+
+[[nodiscard]] DeviceImage createImageFromData(
+    const ImageData& data,
+    const BufferManager& bufferManager
+);
 
 [[nodiscard]] DeviceImage createImageFromFile(
     const string& filename,
@@ -0,0 +1,124 @@
+# packs images into texture atlas pages with ImageMagick and writes a manifest
+# of where each image ended up. Run with cmake -P, see add_texture_atlas:
+#   MAGICK_EXECUTABLE  ImageMagick
+#   TEXC_EXECUTABLE    optional, also writes every page as compressed .ktx2 (see texc.cpp)
+#   ATLAS_NAME         pages are written to OUTPUT_DIR/<ATLAS_NAME>_<page>.png
+#   OUTPUT_DIR
+#   MANIFEST           manifest to write, next to the pages
+#   PAGE_SIZE          maximum width and height of a page
+#   SOURCES            name=image pairs separated by |
+#
+# manifest lines (sizes in pixels, pages relative to the manifest):
+#   page <index> <file> <width> <height>
+#   region <name> <page> <x> <y> <width> <height>
+
+cmake_minimum_required (VERSION 3.30)
+
+# keeps linear filtering from picking up the neighbours. Regions start on
+# compression block boundaries and the pages only get the first mip levels,
+# further down the neighbours would bleed in anyway
+set (PADDING 8)
+set (ALIGNMENT 4)
+set (MIP_LEVELS 3)
+
+string(REPLACE "|" ";" SOURCES "${SOURCES}")
+set (ENTRIES)
+foreach (SOURCE IN LISTS SOURCES)
+    string(REGEX REPLACE "=.*$" "" NAME "${SOURCE}")
+    string(REGEX REPLACE "^[^=]*=" "" IMAGE "${SOURCE}")
+    execute_process(
+        COMMAND ${MAGICK_EXECUTABLE} identify -format "%w %h" "${IMAGE}[0]"
+        OUTPUT_VARIABLE SIZE
+        RESULT_VARIABLE RESULT
+    )
+    if (NOT RESULT EQUAL 0)
+        message(FATAL_ERROR "Failed to read size of '${IMAGE}'")
+    endif()
+    separate_arguments(SIZE)
+    list(GET SIZE 0 WIDTH)
+    list(GET SIZE 1 HEIGHT)
+    if (WIDTH GREATER PAGE_SIZE OR HEIGHT GREATER PAGE_SIZE)
+        message(FATAL_ERROR "'${IMAGE}' (${WIDTH}x${HEIGHT}) doesn't fit into a ${PAGE_SIZE} atlas page")
+    endif()
+
+    # tallest images first keep the shelves tight, the offset makes the text sort numeric
+    math(EXPR KEY "10000000+${HEIGHT}")
+    list(APPEND ENTRIES "${KEY}|${NAME}|${IMAGE}|${WIDTH}|${HEIGHT}")
+endforeach()
+list(SORT ENTRIES ORDER DESCENDING)
+
+# shelf packing: fill rows left to right, start a new row when the image
+# doesn't fit anymore and a new page when the row doesn't
+set (PAGE 0)
+set (X 0)
+set (Y 0)
+set (SHELF 0)
+set (PAGE_WIDTH_0 0)
+set (PAGE_HEIGHT_0 0)
+set (PAGE_IMAGES_0)
+set (REGIONS "")
+foreach (ENTRY IN LISTS ENTRIES)
+    string(REPLACE "|" ";" FIELDS "${ENTRY}")
+    list(GET FIELDS 1 NAME)
+    list(GET FIELDS 2 IMAGE)
+    list(GET FIELDS 3 WIDTH)
+    list(GET FIELDS 4 HEIGHT)
+
+    math(EXPR RIGHT "${X}+${WIDTH}")
+    if (RIGHT GREATER PAGE_SIZE)
+        math(EXPR Y "(${Y}+${SHELF}+${PADDING}+${ALIGNMENT}-1)/${ALIGNMENT}*${ALIGNMENT}")
+        set (X 0)
+        set (SHELF 0)
+    endif()
+    math(EXPR BOTTOM "${Y}+${HEIGHT}")
+    if (BOTTOM GREATER PAGE_SIZE)
+        math(EXPR PAGE "${PAGE}+1")
+        set (X 0)
+        set (Y 0)
+        set (SHELF 0)
+        set (PAGE_WIDTH_${PAGE} 0)
+        set (PAGE_HEIGHT_${PAGE} 0)
+        set (PAGE_IMAGES_${PAGE})
+    endif()
+
+    list(APPEND PAGE_IMAGES_${PAGE} "${IMAGE}" -geometry +${X}+${Y} -composite)
+    string(APPEND REGIONS "region ${NAME} ${PAGE} ${X} ${Y} ${WIDTH} ${HEIGHT}\n")
+
+    math(EXPR RIGHT "${X}+${WIDTH}")
+    math(EXPR BOTTOM "${Y}+${HEIGHT}")
+    if (RIGHT GREATER PAGE_WIDTH_${PAGE})
+        set (PAGE_WIDTH_${PAGE} ${RIGHT})
+    endif()
+    if (BOTTOM GREATER PAGE_HEIGHT_${PAGE})
+        set (PAGE_HEIGHT_${PAGE} ${BOTTOM})
+    endif()
+    if (HEIGHT GREATER SHELF)
+        set (SHELF ${HEIGHT})
+    endif()
+    math(EXPR X "(${X}+${WIDTH}+${PADDING}+${ALIGNMENT}-1)/${ALIGNMENT}*${ALIGNMENT}")
+endforeach()
+
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+set (PAGES "")
+foreach (INDEX RANGE ${PAGE})
+    set (FILE ${ATLAS_NAME}_${INDEX}.png)
+    execute_process(
+        COMMAND ${MAGICK_EXECUTABLE} -size ${PAGE_WIDTH_${INDEX}}x${PAGE_HEIGHT_${INDEX}} xc:none ${PAGE_IMAGES_${INDEX}} ${OUTPUT_DIR}/${FILE}
+        RESULT_VARIABLE RESULT
+    )
+    if (NOT RESULT EQUAL 0)
+        message(FATAL_ERROR "Failed to write atlas page '${OUTPUT_DIR}/${FILE}'")
+    endif()
+    if (TEXC_EXECUTABLE)
+        execute_process(
+            COMMAND ${TEXC_EXECUTABLE} --max-levels ${MIP_LEVELS} ${OUTPUT_DIR}/${FILE} ${OUTPUT_DIR}/${ATLAS_NAME}_${INDEX}.ktx2
+            RESULT_VARIABLE RESULT
+        )
+        if (NOT RESULT EQUAL 0)
+            message(FATAL_ERROR "Failed to compress atlas page '${OUTPUT_DIR}/${FILE}'")
+        endif()
+    endif()
+    string(APPEND PAGES "page ${INDEX} ${FILE} ${PAGE_WIDTH_${INDEX}} ${PAGE_HEIGHT_${INDEX}}\n")
+endforeach()
+
+file(WRITE ${MANIFEST} "${PAGES}${REGIONS}")
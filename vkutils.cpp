@@ -82,13 +82,14 @@ findAppropriateDeviceAndQueueFamily(
     return tie(chosenPhysicalDevice, graphicsQueue, presentQueue);
 }
 
-[[nodiscard]] tuple<vk::raii::SwapchainKHR, vk::Format, vk::Extent2D>
+[[nodiscard]] tuple<vk::raii::SwapchainKHR, vk::Format, vk::Extent2D, vk::ImageUsageFlags>
 createSwapChain(
     const vk::raii::PhysicalDevice& physicalDevice,
     const vk::raii::Device& device,
     const vk::raii::SurfaceKHR& surface,
     const vk::SurfaceFormatKHR& format,
-    const SwapChainRequirements& requirements
+    const SwapChainRequirements& requirements,
+    vk::SwapchainKHR oldSwapchain
 )
 {
     //! pick a presentation mode
@@ -119,6 +120,10 @@ createSwapChain(
     if (surfaceCapabilities.maxImageCount > 0 && minImageCount > surfaceCapabilities.maxImageCount)
         minImageCount =  surfaceCapabilities.maxImageCount;
 
+    // blitting the scene needs transfer, which not every surface offers
+    auto usage=vk::ImageUsageFlags(vk::ImageUsageFlagBits::eColorAttachment);
+    if (surfaceCapabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferDst) usage|=vk::ImageUsageFlagBits::eTransferDst;
+
     std::pair<uint32_t,uint32_t> vals;
     auto swapChainCreateInfo = vk::SwapchainCreateInfoKHR
     {
@@ -128,12 +133,13 @@ createSwapChain(
         .imageColorSpace = format.colorSpace,
         .imageExtent = extent,
         .imageArrayLayers =1,
-        .imageUsage = vk::ImageUsageFlagBits::eColorAttachment,
+        .imageUsage = usage,
         .imageSharingMode = vk::SharingMode::eExclusive,
         .preTransform = surfaceCapabilities.currentTransform,
         .compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque,
         .presentMode = presentMode,
         .clipped = true,
+        .oldSwapchain = oldSwapchain
     };
     
     if (requirements.queueIndices)
@@ -145,7 +151,7 @@ createSwapChain(
 
     auto chain=vk::raii::SwapchainKHR(device, swapChainCreateInfo);
     // std::tie doesn't work here for some reason
-    return make_tuple(std::move(chain), format.format, extent);
+    return make_tuple(std::move(chain), format.format, extent, usage);
 }
 
 [[nodiscard]] vk::raii::ShaderModule loadShaderModule(const vk::raii::Device& device, const string& filename)
@@ -191,13 +197,12 @@ createSwapChain(
     throw std::runtime_error("failed to find suitable memory type!");
 }
 
-[[nodiscard]] vk::raii::Sampler createSampler(
-    const vk::raii::PhysicalDevice& physicalDevice,
-    const vk::raii::Device& device
+[[nodiscard]] vk::SamplerCreateInfo getDefaultSamplerInfo(
+    const vk::raii::PhysicalDevice& physicalDevice
 )
 {
     auto properties = physicalDevice.getProperties();
-    return vk::raii::Sampler(device, vk::SamplerCreateInfo{
+    return vk::SamplerCreateInfo{
         .magFilter = vk::Filter::eLinear,
         .minFilter = vk::Filter::eLinear,
         .mipmapMode = vk::SamplerMipmapMode::eLinear,
@@ -206,5 +211,20 @@ createSwapChain(
         .addressModeW = vk::SamplerAddressMode::eRepeat,
         .anisotropyEnable = vk::True,
         .maxAnisotropy = properties.limits.maxSamplerAnisotropy,
-    });
-}
\ No newline at end of file
+        .maxLod = vk::LodClampNone,     // use all mip levels the image has
+    };
+}
+
+[[nodiscard]] vk::SampleCountFlagBits getSupportedSampleCount(
+    const vk::raii::PhysicalDevice& physicalDevice,
+    uint32_t requested
+)
+{
+    auto supported=physicalDevice.getProperties().limits.framebufferColorSampleCounts;
+    for (uint32_t samples=64; samples>1; samples/=2)
+    {
+        auto flag=vk::SampleCountFlagBits(samples);
+        if (samples<=requested && (supported & flag)) return flag;
+    }
+    return vk::SampleCountFlagBits::e1;
+}
@@ -29,13 +29,15 @@ struct SwapChainRequirements
     optional<pair<uint32_t,uint32_t>> queueIndices={};
 };
 
-[[nodiscard]] tuple<vk::raii::SwapchainKHR, vk::Format, vk::Extent2D>
+//! the usage has eTransferDst only when the surface supports it
+[[nodiscard]] tuple<vk::raii::SwapchainKHR, vk::Format, vk::Extent2D, vk::ImageUsageFlags>
 createSwapChain(
     const vk::raii::PhysicalDevice& physicalDevice,
     const vk::raii::Device& device,
     const vk::raii::SurfaceKHR& surface,
     const vk::SurfaceFormatKHR& format,
-    const SwapChainRequirements& requirements={}
+    const SwapChainRequirements& requirements={},
+    vk::SwapchainKHR oldSwapchain=nullptr       // handed over to the new chain, still has to be destroyed
 );
 
 [[nodiscard]] vk::raii::ShaderModule loadShaderModule(
@@ -50,8 +52,15 @@ createSwapChain(
     vk::MemoryPropertyFlags properties
 );
 
-[[nodiscard]] vk::raii::Sampler createSampler(
-    const vk::raii::PhysicalDevice& physicalDevice,
-    const vk::raii::Device& device
+//! linear filtering with mipmaps, repeating and anisotropic. Get the sampler
+//! from PipelineRegistry::getSampler instead of creating one per texture.
+[[nodiscard]] vk::SamplerCreateInfo getDefaultSamplerInfo(
+    const vk::raii::PhysicalDevice& physicalDevice
 );
 
+
+//! the largest sample count up to requested the device can render color attachments with
+[[nodiscard]] vk::SampleCountFlagBits getSupportedSampleCount(
+    const vk::raii::PhysicalDevice& physicalDevice,
+    uint32_t requested
+);
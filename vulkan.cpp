@@ -21,12 +21,18 @@ Vulkan::Vulkan() :
     graphicsQueue(nullptr),
     presentQueue(nullptr),
     graphicsQueueIndex(-1),
-    presentQueueIndex(-1)
+    presentQueueIndex(-1),
+    frameTimeline(nullptr),
+    recordedFrames(0),
+    retired()
 {
 }
 
 void Vulkan::cleanup()
 {
+    retired.clear();
+    frameTimeline = nullptr;
+    registry = nullptr;
     bufferManager = nullptr;
     vmaAllocator.reset();
     presentQueue=nullptr;
@@ -37,6 +43,26 @@ void Vulkan::cleanup()
     instance=nullptr;
 }
 
+void Vulkan::waitForFrame(uint64_t frame)
+{
+    if (frame>0)
+    {
+        vk::Semaphore semaphore=frameTimeline;
+        auto waitInfo=vk::SemaphoreWaitInfo{
+            .semaphoreCount = 1,
+            .pSemaphores = &semaphore,
+            .pValues = &frame
+        };
+        if (device.waitSemaphores(waitInfo, numeric_limits<uint64_t>::max()) != vk::Result::eSuccess)
+            throw runtime_error("failed to wait for frame "+to_string(frame));
+    }
+
+    // the GPU may be further along, retired in order, so the ones that are done are at the front
+    auto completed=frameTimeline.getCounterValue();
+    auto done=ranges::find_if(retired, [completed](const auto& r) { return r.first>completed; });
+    retired.erase(retired.begin(), done);
+}
+
 void Vulkan::initializeInstance(
     const char* name,
     uint32_t version,
@@ -72,7 +98,7 @@ void Vulkan::initializeDeviceInternal
 (
     uint32_t apiVersion,
     vector<const char*> deviceExtensions,
-    const void* featuresHead
+    void* featuresHead
 )
 {
 #ifdef __APPLE__
@@ -89,6 +115,16 @@ void Vulkan::initializeDeviceInternal
         }
     );
 
+    //! texture compression is optional, decodeImageFile falls back to the
+    //! uncompressed source image when the device has none
+    auto head=static_cast<vk::BaseOutStructure*>(featuresHead);
+    if (head!=nullptr && head->sType==vk::StructureType::ePhysicalDeviceFeatures2)
+    {
+        auto& features=static_cast<vk::PhysicalDeviceFeatures2*>(featuresHead)->features;
+        features.textureCompressionBC=features.textureCompressionBC && physicalDevice.getFeatures().textureCompressionBC;
+        enabledFeatures=features;
+    }
+
     float prio = 1.0f;
     auto queueInfo = vk::DeviceQueueCreateInfo
     {
@@ -115,7 +151,11 @@ void Vulkan::initializeDeviceInternal
         .instance=instance
     });
     
+    auto timelineInfo=vk::SemaphoreTypeCreateInfo{ .semaphoreType = vk::SemaphoreType::eTimeline, .initialValue = 0 };
+    frameTimeline = vk::raii::Semaphore(device, vk::SemaphoreCreateInfo{ .pNext = &timelineInfo });
+
     bufferManager = make_unique<BufferManager>(*vmaAllocator, device, graphicsQueue, graphicsQueueIndex);
+    registry = make_unique<PipelineRegistry>(device, physicalDevice);
 
     //! pick a color format for our swap chain
     auto availableFormats=physicalDevice.getSurfaceFormatsKHR(surface);
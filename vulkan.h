@@ -6,6 +6,7 @@
 #include "common.h"
 #include "vma.h"
 #include "buffermanager.h"
+#include "pipelineregistry.h"
 
 #ifdef VULKAN_INCLUDE_GLFW
 #define GLFW_INCLUDE_VULKAN
@@ -135,7 +136,7 @@ private:
     (
         uint32_t apiVersion,
         vector<const char*> deviceExtensions,
-        const void* featuresHead
+        void* featuresHead
     );
 
 public:
@@ -150,8 +151,27 @@ public:
 
     inline const vma::UniqueAllocator& getVmaAllocator() const noexcept { return vmaAllocator; }
     inline const BufferManager& getBufferManager() const noexcept { return *bufferManager; }
+    inline PipelineRegistry& getRegistry() const noexcept { return *registry; }
 
     inline const vk::SurfaceFormatKHR& getSwapChainFormat() const noexcept { return swapChainFormat; }
+    //! the requested features minus the optional ones the device does not have
+    inline const vk::PhysicalDeviceFeatures& getEnabledFeatures() const noexcept { return enabledFeatures; }
+
+    //! @brief keeps object alive until the GPU is done with every frame recorded so far,
+    //! so resources still used by frames in flight can be replaced without waitIdle.
+    //! Objects that depend on each other go in as one pair, which destroys second
+    //! before first.
+    template<typename T>
+    inline void retire(T&& object)
+    {
+        retired.emplace_back(recordedFrames, make_shared<remove_cvref_t<T>>(std::forward<T>(object)));
+    }
+    //! @brief frames are numbered from 1 and the submission of a frame signals its
+    //! number on this timeline semaphore, so waiting for a frame is waiting for a value
+    inline const vk::raii::Semaphore& getFrameTimeline() const noexcept { return frameTimeline; }
+    inline uint64_t beginFrame() noexcept { return ++recordedFrames; }
+    //! blocks until the GPU finished frame, then destroys what it no longer needs
+    void waitForFrame(uint64_t frame);
 
 private:
     vk::raii::Context context;
@@ -166,8 +186,15 @@ private:
 
     vma::UniqueAllocator vmaAllocator;
     unique_ptr<BufferManager> bufferManager;
+    unique_ptr<PipelineRegistry> registry;
 
     vk::SurfaceFormatKHR swapChainFormat;
+    vk::PhysicalDeviceFeatures enabledFeatures;
+
+    vk::raii::Semaphore frameTimeline;
+    uint64_t recordedFrames;
+    //! with the last frame that may still use them
+    vector<pair<uint64_t, shared_ptr<void>>> retired;
 };
 
 extern Vulkan vulkan;
\ No newline at end of file